@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 18 Oct 2026 2:05:51pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "VoiceKernel.h"
+#include "Oversampler.h"
+#include "CpuDispatch.h"
+
+namespace
+{
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    template <typename SineType>
+    double measureMaxError()
+    {
+        const int numPoints = 1 << 16;
+        double maxError = 0.0;
+        
+        // odd steps so the low phase bits are exercised too
+        const juce::uint32 step = (juce::uint32) (Phase::cycle / numPoints) + 1;
+        
+        for (int i = 0; i < numPoints; i++)
+        {
+            juce::uint32 phase = (juce::uint32) i * step;
+            float value = SineType::template process<Lanes>(Phase::Bits<Lanes>::expand(phase)).get(0);
+            maxError = juce::jmax(maxError, std::abs(value - std::sin(juce::MathConstants<double>::twoPi * phase / Phase::cycle)));
+        }
+        return maxError;
+    }
+
+    // nanoseconds per voice per sample through a stack of numStacked operators, ... -> 2 -> 1 -> 0,
+    // in the kernel built for NumOperators
+    template <typename SineType, int NumOperators>
+    double measureOperatorCost(int numStacked)
+    {
+        VoiceKernel::VoiceLanes<Lanes, NumOperators> lanes;
+        std::array<int, Routing::maxOperators> operatorRouting {};
+        for (int i = 0; i < numStacked - 1; i++)
+            operatorRouting[i] = 1 << (i + 1);
+        
+        auto schedule = Routing::compile(operatorRouting, 1, NumOperators);
+        
+        for (int i = 0; i < NumOperators; i++)
+        {
+            lanes[i].increment = Phase::Bits<Lanes>::expand(Phase::fromCycles(0.01 * (i + 1)));
+            lanes[i].modIndex = Lanes::expand(2.0f / juce::MathConstants<float>::twoPi);
+            lanes[i].envelope = Lanes::expand(1.0f);
+        }
+
+        const int numSamples = 1 << 18;
+        auto mix = Lanes::expand(0.0f);
+        auto start = juce::Time::getHighResolutionTicks();
+        
+        for (int i = 0; i < numSamples; i++)
+            mix += VoiceKernel::processSample<SineType>(lanes, schedule);
+        
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        
+        // keep the result alive so the loop isn't optimised away
+        static volatile float sink;
+        sink = mix.sum();
+        
+        return seconds * 1.0e9 / ((double) numSamples * Lanes::size());
+    }
+
+    // nanoseconds per output sample to bring the mix down from 2^numStages times the rate
+    double measureDecimationCost(int numStages)
+    {
+        const int blockSize = 256;
+        const int numBlocks = 1024;
+        
+        Oversampler oversampler;
+        oversampler.prepare(blockSize);
+        
+        auto start = juce::Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; block++)
+        {
+            oversampler.clear(blockSize, numStages);
+            oversampler.getBus(numStages)[block % blockSize] = 1.0f;
+            oversampler.decimate(blockSize, numStages, false);
+        }
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        
+        return seconds * 1.0e9 / ((double) blockSize * numBlocks);
+    }
+    
+    template <typename SineType>
+    juce::String sineReport(const juce::String& name)
+    {
+        return "Sine " + name
+             + ": max error " + juce::String(measureMaxError<SineType>(), 2, true)
+             + ", 8 operators " + juce::String(measureOperatorCost<SineType, 8>(8), 2)
+             + " ns, 6 operators " + juce::String(measureOperatorCost<SineType, 6>(6), 2)
+             + " ns, 4 operators " + juce::String(measureOperatorCost<SineType, 4>(4), 2)
+             + " ns, 2 operators " + juce::String(measureOperatorCost<SineType, 4>(2), 2) + " ns per voice sample\n";
+    }
+}
+
+juce::String Benchmark::run()
+{
+    juce::String report = "Fledge kernel benchmark, " + juce::String((int) Lanes::size()) + " voice lanes\n";
+    report += "CPU " + juce::SystemStats::getCpuModel() + ", " + CpuDispatch::getTargetName() + " kernels\n";
+    
+    Sine::Table::getTable();
+    report += sineReport<Sine::Exact>(Sine::modeNames[0]);
+    report += sineReport<Sine::Table>(Sine::modeNames[1]);
+    report += sineReport<Sine::Polynomial>(Sine::modeNames[2]);
+    
+    // voices cost the factor times the operator figures above, decimation is paid once for the mix
+    for (int stages = 1; stages <= Oversampler::maxStages; stages++)
+        report += "Oversampling " + Oversampler::factorNames[stages] + ": voices x" + juce::String(1 << stages)
+                + ", decimation " + juce::String(measureDecimationCost(stages), 2) + " ns per output sample\n";
+    
+    return report;
+}
@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 18 Oct 2026 2:05:51pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Build with FLEDGE_BENCHMARK=1 to log the report when the plugin is created.
+#ifndef FLEDGE_BENCHMARK
+ #define FLEDGE_BENCHMARK 0
+#endif
+
+namespace Benchmark
+{
+    // timing and accuracy of the DSP kernels on this machine
+    juce::String run();
+}
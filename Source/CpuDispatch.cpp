@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    CpuDispatch.cpp
+    Created: 18 Oct 2026 11:04:12pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "CpuDispatch.h"
+
+namespace
+{
+    CpuDispatch::Target detectTarget()
+    {
+        using Target = CpuDispatch::Target;
+        using Stats = juce::SystemStats;
+
+       #if FLEDGE_CPU_DISPATCH
+        if (Stats::hasAVX2() && Stats::hasFMA3())
+            return Target::avx2;
+       #endif
+
+       #if JUCE_USE_SSE_INTRINSICS
+        return Target::sse2;
+       #elif JUCE_USE_ARM_NEON
+        return Target::neon;
+       #else
+        return Target::generic;
+       #endif
+    }
+}
+
+CpuDispatch::Target CpuDispatch::getTarget()
+{
+    static const Target target = detectTarget();
+    return target;
+}
+
+juce::String CpuDispatch::getTargetName()
+{
+    return targetNames[(int) getTarget()];
+}
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    CpuDispatch.h
+    Created: 18 Oct 2026 11:04:12pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Instruction set the DSP kernels run with, picked once from the CPU's feature
+// flags. The portable build is the baseline, SSE2 on Intel and NEON on ARM. With
+// GCC and Clang the half-band decimator has an AVX2 kernel, eight outputs per
+// register, compiled through a target attribute.
+//
+// The voice kernel has no variants: its lanes are a juce::dsp::SIMDRegister, four
+// floats on Intel, and a copy for a wider target would run the same four lanes.
+// The mix adds and the envelopes stay on the baseline too, they are memory bound
+// or run once per control period.
+namespace CpuDispatch
+{
+    enum class Target { generic, sse2, avx2, neon };
+    inline const juce::StringArray targetNames { "Generic", "SSE2", "AVX2", "NEON" };
+
+    Target getTarget();
+    juce::String getTargetName();
+}
+
+#if JUCE_INTEL && (defined (__GNUC__) || defined (__clang__))
+ #define FLEDGE_CPU_DISPATCH 1
+ #define FLEDGE_TARGET_AVX2 __attribute__((target ("avx2,fma")))
+#else
+ #define FLEDGE_CPU_DISPATCH 0
+#endif
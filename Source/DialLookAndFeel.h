@@ -149,6 +149,12 @@ public:
     
     void mouseDown(const juce::MouseEvent& m) override
     {
+        if (m.mods.isPopupMenu())
+        {
+            showMidiLearnMenu();
+            return;
+        }
+        
         auto mousePoint = m.getPosition().toFloat();
         dragStartPoint.y = mousePoint.y;
         
@@ -158,6 +164,9 @@ public:
 
     void mouseDrag(const juce::MouseEvent& m) override
     {
+        if (m.mods.isPopupMenu())
+            return;
+        
         auto mousePoint = m.getPosition().toFloat();
         float deltaY = mousePoint.y - dragStartPoint.y; // Remove std::abs to allow bidirectional dragging
         
@@ -233,6 +242,25 @@ public:
         }
     }
 
+    // right click: map the next controller that moves to this parameter, or remove its mapping
+    void showMidiLearnMenu()
+    {
+        auto& midiLearn = audioProcessor.getMidiLearn();
+        int index = audioProcessor.apvts.getParameter(parameterID)->getParameterIndex();
+        int controller = midiLearn.getController(index);
+        
+        juce::PopupMenu menu;
+        if (midiLearn.isLearning(index))
+            menu.addItem("Cancel MIDI Learn", [&midiLearn] { midiLearn.learn(MidiLearn::none); });
+        else
+            menu.addItem("MIDI Learn", [&midiLearn, index] { midiLearn.learn(index); });
+        
+        if (controller != MidiLearn::none)
+            menu.addItem("Forget CC " + juce::String(controller), [&midiLearn, index] { midiLearn.forget(index); });
+        
+        menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this));
+    }
+    
     void setFontSize(float size)
     {
         textBox.setFont(juce::FontOptions(size, juce::Font::plain));
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    Envelope.cpp
+    Created: 18 Oct 2026 7:26:51pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "Envelope.h"
+
+namespace
+{
+    // how far past its end point each segment aims, small values are more exponential
+    constexpr double attackOvershoot = 0.3;
+    constexpr double decayOvershoot = 0.001;
+
+    // coefficient for going from start to end in numSamples, aiming at target
+    void setSegment(Envelope::Shape::Segment& segment, int op, double start, double end, double target, double numSamples,
+                    int controlInterval)
+    {
+        double coefficient = 0.0;
+        if (numSamples > 1.0 && std::abs(start - end) > 0.0)
+            coefficient = std::exp(std::log((end - target) / (start - target)) / numSamples);
+        else
+            target = end; // instant, the first advance lands on the end point
+
+        segment.coefficient[op] = (float) coefficient;
+        segment.periodCoefficient[op] = (float) std::pow(coefficient, controlInterval);
+        segment.target[op] = (float) target;
+    }
+}
+
+Envelope::Shape Envelope::makeShape(const std::array<Parameters, maxOperators>& parameters, int numOperators, double sampleRate, int controlInterval)
+{
+    Shape shape;
+    shape.controlInterval = controlInterval;
+    shape.numOperators = numOperators;
+    
+    for (int op = 0; op < maxOperators; op++)
+    {
+        const auto& p = parameters[op];
+        double sustain = juce::jlimit(0.0, 1.0, (double) p.sustain);
+
+        // attack and release times are from silence to full scale, decay is down to the sustain level
+        setSegment(shape.attack, op, 0.0, 1.0, 1.0 + attackOvershoot, p.attack * sampleRate, controlInterval);
+        setSegment(shape.decay, op, 1.0, sustain, sustain - decayOvershoot, p.decay * sampleRate, controlInterval);
+        setSegment(shape.release, op, 1.0, 0.0, -decayOvershoot, p.release * sampleRate, controlInterval);
+
+        shape.sustain[op] = (float) sustain;
+        shape.isLooping[op] = p.isLooping;
+    }
+    return shape;
+}
+
+void Envelope::Generator::noteOn(const Shape& shape)
+{
+    for (int op = 0; op < shape.numOperators; op++)
+        enterStage(op, Stage::attack, shape);
+}
+
+void Envelope::Generator::noteOff(const Shape& shape)
+{
+    for (int op = 0; op < maxOperators; op++)
+        if (stage[op] != Stage::idle)
+            enterStage(op, Stage::release, shape);
+}
+
+void Envelope::Generator::reset()
+{
+    level.fill(0.0f);
+    coefficient.fill(0.0f);
+    periodCoefficient.fill(0.0f);
+    target.fill(0.0f);
+    remaining.fill(idleLength);
+    stage.fill(Stage::idle);
+}
+
+void Envelope::Generator::advance(const Shape& shape, int numSamples)
+{
+    for (int op = 0; op < maxOperators; op++)
+    {
+        // holding stages never change the level
+        for (int n = numSamples; n > 0 && remaining[op] != idleLength;)
+        {
+            int run = juce::jmin(n, remaining[op]);
+            float power = run == shape.controlInterval ? periodCoefficient[op] : std::pow(coefficient[op], (float) run);
+            level[op] = target[op] + (level[op] - target[op]) * power;
+            
+            n -= run;
+            remaining[op] -= run;
+            if (remaining[op] == 0)
+                finishSegment(op, shape);
+        }
+    }
+}
+
+void Envelope::Generator::enterStage(int op, Stage newStage, const Shape& shape)
+{
+    float current = level[op];
+    stage[op] = newStage;
+
+    const Shape::Segment* segment = nullptr;
+    float end = 0.0f;
+
+    switch (newStage)
+    {
+        case Stage::attack:  segment = &shape.attack;  end = 1.0f;              break;
+        case Stage::decay:   segment = &shape.decay;   end = shape.sustain[op]; break;
+        case Stage::release: segment = &shape.release; end = 0.0f;              break;
+
+        case Stage::sustain:
+        case Stage::idle:
+            // hold the level, idle holds zero
+            if (newStage == Stage::idle)
+                level[op] = 0.0f;
+            coefficient[op] = periodCoefficient[op] = 1.0f;
+            target[op] = level[op];
+            remaining[op] = idleLength;
+            return;
+    }
+
+    float c = segment->coefficient[op];
+    coefficient[op] = c;
+    periodCoefficient[op] = segment->periodCoefficient[op];
+    target[op] = segment->target[op];
+
+    // whole samples before the level reaches the end point, it is snapped onto it afterwards
+    double samples = 0.0;
+    double ratio = (end - target[op]) / (current - target[op]);
+    if (c > 0.0f && ratio > 0.0 && ratio < 1.0)
+        samples = std::floor(std::log(ratio) / std::log((double) c));
+
+    // a loop of instant segments would never leave the loop in advance
+    if (shape.isLooping[op])
+        samples = juce::jmax(samples, 1.0);
+
+    remaining[op] = (int) juce::jmin(samples, (double) idleLength - 1.0);
+}
+
+void Envelope::Generator::finishSegment(int op, const Shape& shape)
+{
+    switch (stage[op])
+    {
+        case Stage::attack:
+            level[op] = 1.0f;
+            enterStage(op, Stage::decay, shape);
+            break;
+        case Stage::decay:
+            level[op] = shape.sustain[op];
+            enterStage(op, shape.isLooping[op] ? Stage::attack : Stage::sustain, shape);
+            break;
+        case Stage::release:
+            enterStage(op, Stage::idle, shape);
+            break;
+        case Stage::sustain:
+        case Stage::idle:
+            break;
+    }
+}
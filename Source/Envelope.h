@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    Envelope.h
+    Created: 18 Oct 2026 7:26:51pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Routing.h"
+
+// Exponential ADSR for the operators of a voice. Every segment is
+// level = level * coefficient + base per sample, aimed slightly past its end
+// point, which has the closed form target + (level - target) * coefficient^n.
+// The generator only runs at control rate and jumps a whole control period at
+// once, the kernel interpolates the levels in between. Segment lengths are
+// solved when a segment starts, so a jump never has to search for its end.
+namespace Envelope
+{
+    struct Parameters
+    {
+        float attack = 0.01f;  // seconds
+        float decay = 0.2f;    // seconds
+        float sustain = 0.8f;  // 0 to 1
+        float release = 1.0f;  // seconds
+        bool isLooping = false; // attack again instead of holding the sustain level
+    };
+
+    enum class Stage { idle, attack, decay, sustain, release };
+
+    constexpr int maxOperators = Routing::maxOperators;
+
+    // segment constants for one patch, shared by every voice
+    struct Shape
+    {
+        struct Segment
+        {
+            std::array<float, maxOperators> coefficient, target;
+            std::array<float, maxOperators> periodCoefficient; // coefficient^controlInterval
+        };
+
+        Segment attack, decay, release;
+        std::array<float, maxOperators> sustain;
+        std::array<bool, maxOperators> isLooping;
+        int controlInterval = 1;
+        int numOperators = 4; // the others stay idle
+    };
+
+    Shape makeShape(const std::array<Parameters, maxOperators>& parameters, int numOperators, double sampleRate, int controlInterval);
+
+    class Generator
+    {
+    public:
+        Generator() { reset(); }
+
+        void noteOn(const Shape& shape);
+        void noteOff(const Shape& shape);
+        void reset();
+
+        // moves every operator numSamples ahead, crossing into later segments as needed
+        void advance(const Shape& shape, int numSamples);
+
+        bool isActive(int op) const { return stage[op] != Stage::idle; }
+        float getLevel(int op) const { return level[op]; }
+        
+        // stays exactly zero until the next note on or note off, idle or sustaining at zero
+        bool isSilent(int op) const
+        {
+            return stage[op] == Stage::idle || (stage[op] == Stage::sustain && level[op] == 0.0f);
+        }
+
+    private:
+        void enterStage(int op, Stage newStage, const Shape& shape);
+        void finishSegment(int op, const Shape& shape);
+
+        std::array<float, maxOperators> level;
+        std::array<float, maxOperators> coefficient, periodCoefficient, target;
+        std::array<int, maxOperators> remaining;
+        std::array<Stage, maxOperators> stage;
+
+        static constexpr int idleLength = std::numeric_limits<int>::max();
+    };
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    Glide.h
+    Created: 18 Oct 2026 11:41:27pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Portamento for one voice. The pitch in semitones slides towards the last note
+// the voice was given, moving only at control rate while the operators ramp
+// their frequency in between. A voice that isn't sliding does no work here.
+class Glide
+{
+public:
+    enum class Mode { legato, always };
+    enum class Shape { constantTime, exponential };
+    static inline const juce::StringArray modeNames { "Legato", "Always" };
+    static inline const juce::StringArray shapeNames { "Constant Time", "Exponential" };
+
+    struct Settings
+    {
+        float time = 0.0f; // seconds, no glide at 0
+        Mode mode = Mode::legato; // legato only slides into a note played while another is held
+        Shape shape = Shape::constantTime; // exponential is within 1% of the note after time
+
+        bool isOn() const { return time > 0.0f; }
+    };
+
+    static float toFrequency(float pitch) { return 440.0f * std::exp2((pitch - 69.0f) / 12.0f); }
+
+    void jumpTo(float pitch)
+    {
+        current = target = pitch;
+        rate = 0.0f;
+    }
+
+    void slideTo(float pitch)
+    {
+        target = pitch;
+        rate = 0.0f; // constant time slides measure the new distance
+    }
+
+    float getPitch() const { return current; }
+    float getTarget() const { return target; }
+    bool isSliding() const { return current != target; }
+
+    void advance(int numSamples, const Settings& settings, double sampleRate)
+    {
+        if (current == target)
+            return;
+
+        if (! settings.isOn())
+        {
+            current = target;
+            return;
+        }
+
+        const double length = settings.time * sampleRate;
+
+        if (settings.shape == Shape::exponential)
+        {
+            current = target + (current - target) * (float) std::pow(0.01, numSamples / length);
+            if (std::abs(current - target) < closeEnough)
+                current = target;
+            return;
+        }
+
+        if (rate == 0.0f)
+            rate = (float) ((target - current) / length);
+
+        float step = rate * (float) numSamples;
+        current = std::abs(target - current) <= std::abs(step) ? target : current + step;
+    }
+
+private:
+    static constexpr float closeEnough = 0.001f; // semitones
+
+    float current = 69.0f, target = 69.0f;
+    float rate = 0.0f; // semitones per sample of a constant time slide
+};
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    MidiLearn.cpp
+    Created: 19 Oct 2026 12:26:51am
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "MidiLearn.h"
+
+MidiLearn::MidiLearn(juce::AudioProcessor& processor) : processor(processor)
+{
+    startTimerHz(publishRate);
+}
+
+MidiLearn::~MidiLearn()
+{
+    stopTimer();
+}
+
+void MidiLearn::learn(int parameterIndex)
+{
+    learning.store(parameterIndex);
+}
+
+void MidiLearn::forget(int parameterIndex)
+{
+    int expected = parameterIndex;
+    learning.compare_exchange_strong(expected, none);
+
+    for (auto& controller : controllers)
+        if (controller.parameter.load() == parameterIndex)
+            controller.parameter.store(none);
+}
+
+int MidiLearn::getController(int parameterIndex) const
+{
+    for (int c = 0; c < numControllers; c++)
+        if (controllers[(size_t) c].parameter.load() == parameterIndex)
+            return c;
+    return none;
+}
+
+void MidiLearn::map(int controller, int parameterIndex)
+{
+    for (auto& other : controllers)
+        if (other.parameter.load() == parameterIndex)
+            other.parameter.store(none);
+
+    controllers[(size_t) controller].parameter.store(parameterIndex);
+}
+
+void MidiLearn::handleController(int controller, int value)
+{
+    jassert(controller >= 0 && controller < numControllers);
+
+    int index = learning.load();
+    if (index != none && learning.compare_exchange_strong(index, none))
+        map(controller, index);
+
+    auto& mapped = controllers[(size_t) controller];
+    if (followMapping(mapped) != none)
+        mapped.target = (float) value / 127.0f;
+}
+
+// the values go to the host from here, so a controller sweep costs it one change per
+// parameter and tick however many messages came in
+void MidiLearn::timerCallback()
+{
+    auto changes = unpublished.takeChanges();
+    if (changes.none())
+        return;
+
+    const auto& parameters = processor.getParameters();
+    for (int c = 0; c < numControllers; c++)
+    {
+        int index = controllers[(size_t) c].parameter.load();
+        if (changes[(size_t) c] && index != none)
+        {
+            publishing.store(index);
+            parameters[index]->setValueNotifyingHost(controllers[(size_t) c].value.load());
+            publishing.store(none);
+        }
+    }
+}
+
+std::unique_ptr<juce::XmlElement> MidiLearn::createXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>(xmlTag);
+    const auto& parameters = processor.getParameters();
+
+    for (int c = 0; c < numControllers; c++)
+    {
+        int index = controllers[(size_t) c].parameter.load();
+        if (index == none)
+            continue;
+
+        if (auto* parameter = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameters[index]))
+        {
+            auto* mapping = xml->createNewChildElement("MAP");
+            mapping->setAttribute("controller", c);
+            mapping->setAttribute("parameter", parameter->paramID);
+        }
+    }
+    return xml;
+}
+
+void MidiLearn::restoreFromXml(const juce::XmlElement& xml)
+{
+    for (auto& controller : controllers)
+        controller.parameter.store(none);
+
+    const auto& parameters = processor.getParameters();
+    for (auto* mapping : xml.getChildWithTagNameIterator("MAP"))
+    {
+        int controller = mapping->getIntAttribute("controller", none);
+        auto parameterID = mapping->getStringAttribute("parameter");
+        if (controller < 0 || controller >= numControllers)
+            continue;
+
+        for (auto* parameter : parameters)
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+                if (withID->paramID == parameterID)
+                    map(controller, parameter->getParameterIndex());
+    }
+}
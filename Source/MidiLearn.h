@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    MidiLearn.h
+    Created: 19 Oct 2026 12:26:51am
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterChanges.h"
+
+// Controller to parameter map, a fixed table indexed by controller number. The audio
+// thread only reads the table and moves each mapped parameter towards its controller
+// once per block, the host hears about the new values from the message thread at
+// publishRate at most. Parameters are saved by ID, indices may change between versions.
+class MidiLearn : private juce::Timer
+{
+public:
+    static constexpr int numControllers = 128;
+    static constexpr int none = -1;
+    static inline const juce::String xmlTag { "MIDI_LEARN" };
+
+    explicit MidiLearn(juce::AudioProcessor& processor);
+    ~MidiLearn() override;
+
+    // message thread. The next controller to move is mapped to the parameter,
+    // taking over from any controller it had
+    void learn(int parameterIndex);
+    void forget(int parameterIndex);
+    bool isLearning(int parameterIndex) const { return learning.load() == parameterIndex; }
+    int getController(int parameterIndex) const; // none when unmapped
+
+    // true while the parameter is being sent to the host from here.
+    // The audio thread already has a newer value than the one being sent
+    bool isPublishing(int parameterIndex) const { return publishing.load() == parameterIndex; }
+
+    // audio thread, for every controller message of a block before it renders
+    void handleController(int controller, int value);
+
+    // audio thread, once per block. apply(parameterIndex, normalisedValue) is called
+    // for each parameter that moved
+    template <typename Function>
+    void advance(int numSamples, double sampleRate, Function&& apply)
+    {
+        const auto& parameters = processor.getParameters();
+        const float coefficient = 1.0f - (float) std::exp(-numSamples / (smoothingTime * sampleRate));
+
+        for (int c = 0; c < numControllers; c++)
+        {
+            auto& controller = controllers[(size_t) c];
+            int index = followMapping(controller);
+            if (index == none || controller.current == controller.target)
+                continue;
+
+            // a first move starts from wherever the parameter is, switches jump
+            auto* parameter = parameters[index];
+            if (controller.current < 0.0f)
+                controller.current = parameter->getValue();
+
+            if (parameter->isDiscrete() || std::abs(controller.target - controller.current) < closeEnough)
+                controller.current = controller.target;
+            else
+                controller.current += (controller.target - controller.current) * coefficient;
+
+            controller.value.store(controller.current);
+            unpublished.markChanged(c);
+            apply(index, controller.current);
+        }
+    }
+
+    std::unique_ptr<juce::XmlElement> createXml() const;
+    void restoreFromXml(const juce::XmlElement& xml); // message thread
+
+private:
+    static constexpr double smoothingTime = 0.02; // seconds
+    static constexpr float closeEnough = 1.0e-4f;
+    static constexpr int publishRate = 30; // Hz
+
+    struct Controller
+    {
+        std::atomic<int> parameter { none };
+        std::atomic<float> value { 0.0f }; // normalised, the last value applied
+
+        // audio thread only, current is negative until the controller first moves
+        int mappedParameter = none;
+        float target = -1.0f, current = -1.0f;
+    };
+
+    // a controller that was remapped waits to move again rather than pass its old value on
+    static int followMapping(Controller& controller)
+    {
+        int index = controller.parameter.load();
+        if (index != controller.mappedParameter)
+        {
+            controller.mappedParameter = index;
+            controller.target = controller.current = -1.0f;
+        }
+        return index;
+    }
+
+    void timerCallback() override;
+    void map(int controller, int parameterIndex);
+
+    std::array<Controller, numControllers> controllers;
+    std::atomic<int> learning { none };
+    std::atomic<int> publishing { none }; // set by the timer, read from any thread
+    ParameterChanges unpublished; // by controller number
+
+    juce::AudioProcessor& processor;
+};
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    NoteExpression.h
+    Created: 19 Oct 2026 1:08:14am
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "VoiceAllocator.h"
+
+// Per-note pitch bend, pressure and slide by voice index, kept as structure of arrays.
+// Messages set targets, once per control period every sounding voice is smoothed
+// towards them in one pass and left as ramps the voice applies in its control pass.
+// Values at rest are neutral, so voices always apply them and never branch on it.
+//
+// MPE uses the lower zone: channel 1 is the master channel and stays global, notes
+// on channels 2 to 16 are bent and slid by their own channel. Pressure follows the
+// note's channel, or the note itself for polyphonic aftertouch, in either mode.
+class NoteExpression
+{
+public:
+    static constexpr int maxVoices = VoiceAllocator::maxVoices;
+    static constexpr int numChannels = 16;
+    static constexpr int masterChannel = 1;
+
+    struct Settings
+    {
+        bool isMpe = false;
+        float bendRange = 48.0f; // semitones either way on a member channel
+        float pressureDepth = 2.0f; // modulation index added at full pressure
+        float slideDepth = 0.5f; // how far slide scales modulation either side of its centre
+    };
+
+    NoteExpression()
+    {
+        channelBend.fill(0.0f);
+        channelPressure.fill(0.0f);
+        channelSlide.fill(slideCentre);
+
+        for (int v = 0; v < maxVoices; v++)
+            startVoice(v, masterChannel);
+    }
+
+    // leaving MPE lets go of every per-note bend and slide
+    void setSettings(const Settings& newSettings)
+    {
+        if (settings.isMpe && ! newSettings.isMpe)
+        {
+            channelBend.fill(0.0f);
+            channelSlide.fill(slideCentre);
+            bendTarget.fill(0.0f);
+            slideTarget.fill(slideCentre);
+        }
+        settings = newSettings;
+    }
+
+    const Settings& getSettings() const { return settings; }
+
+    // a member channel in MPE mode, where bend and slide belong to the notes
+    bool isPerNote(int midiChannel) const { return settings.isMpe && midiChannel != masterChannel; }
+
+    // the voice starts at its channel's values rather than sliding to them
+    void startVoice(int voice, int midiChannel)
+    {
+        int c = (midiChannel - 1) & (numChannels - 1);
+        channel[(size_t) voice] = midiChannel;
+        bend[(size_t) voice] = bendTarget[(size_t) voice] = settings.isMpe ? channelBend[(size_t) c] : 0.0f;
+        slide[(size_t) voice] = slideTarget[(size_t) voice] = settings.isMpe ? channelSlide[(size_t) c] : slideCentre;
+        pressure[(size_t) voice] = pressureTarget[(size_t) voice] = channelPressure[(size_t) c];
+        bendRatioEnd[(size_t) voice] = toRatio(bend[(size_t) voice]);
+    }
+
+    // bend from -1 to 1, pressure and slide from 0 to 1
+    void setChannelBend(int midiChannel, float value)
+    {
+        channelBend[(size_t) ((midiChannel - 1) & (numChannels - 1))] = value;
+        setTargets(midiChannel, bendTarget, value);
+    }
+
+    void setChannelPressure(int midiChannel, float value)
+    {
+        channelPressure[(size_t) ((midiChannel - 1) & (numChannels - 1))] = value;
+        setTargets(midiChannel, pressureTarget, value);
+    }
+
+    void setChannelSlide(int midiChannel, float value)
+    {
+        channelSlide[(size_t) ((midiChannel - 1) & (numChannels - 1))] = value;
+        setTargets(midiChannel, slideTarget, value);
+    }
+
+    void setNotePressure(int voice, float value) { pressureTarget[(size_t) voice] = value; }
+
+    // one control period for every sounding voice
+    void advance(const VoiceAllocator& allocator, int numSamples, double sampleRate)
+    {
+        const float coefficient = 1.0f - (float) std::exp(-numSamples / (smoothingTime * sampleRate));
+        const float slideScale = 2.0f * settings.slideDepth;
+
+        for (int i = 0; i < allocator.getNumActive(); i++)
+        {
+            const auto v = (size_t) allocator.getActive(i);
+
+            modIndexStart[v] = pressure[v] * settings.pressureDepth;
+            brightnessStart[v] = juce::jmax(0.0f, 1.0f + (slide[v] - slideCentre) * slideScale);
+            bendRatioStart[v] = bendRatioEnd[v];
+
+            pressure[v] += (pressureTarget[v] - pressure[v]) * coefficient;
+            slide[v] += (slideTarget[v] - slide[v]) * coefficient;
+
+            modIndexEnd[v] = pressure[v] * settings.pressureDepth;
+            brightnessEnd[v] = juce::jmax(0.0f, 1.0f + (slide[v] - slideCentre) * slideScale);
+
+            // only a bending note pays for the pow
+            if (bend[v] != bendTarget[v])
+            {
+                bend[v] = std::abs(bendTarget[v] - bend[v]) < closeEnough ? bendTarget[v] : bend[v] + (bendTarget[v] - bend[v]) * coefficient;
+                bendRatioEnd[v] = toRatio(bend[v]);
+            }
+        }
+    }
+
+    // ramps over the last control period, by voice index. The bend multiplies the note
+    // frequency, the modulation index of every operator becomes (index + modIndex) * brightness
+    std::array<float, maxVoices> bendRatioStart {}, bendRatioEnd {};
+    std::array<float, maxVoices> modIndexStart {}, modIndexEnd {};
+    std::array<float, maxVoices> brightnessStart {}, brightnessEnd {};
+
+private:
+    static constexpr double smoothingTime = 0.005; // seconds
+    static constexpr float slideCentre = 0.5f; // where MPE controllers rest
+    static constexpr float closeEnough = 1.0e-5f;
+
+    float toRatio(float value) const { return value == 0.0f ? 1.0f : std::exp2(value * settings.bendRange / 12.0f); }
+
+    void setTargets(int midiChannel, std::array<float, maxVoices>& targets, float value)
+    {
+        for (int v = 0; v < maxVoices; v++)
+            if (channel[(size_t) v] == midiChannel)
+                targets[(size_t) v] = value;
+    }
+
+    Settings settings;
+
+    std::array<int, maxVoices> channel {};
+    std::array<float, maxVoices> bend {}, pressure {}, slide {};
+    std::array<float, maxVoices> bendTarget {}, pressureTarget {}, slideTarget {};
+    std::array<float, numChannels> channelBend {}, channelPressure {}, channelSlide {};
+};
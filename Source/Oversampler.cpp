@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    Oversampler.cpp
+    Created: 18 Oct 2026 6:03:19pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+
+#if FLEDGE_CPU_DISPATCH
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    // zeroth order modified Bessel function of the first kind, for the Kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+// Kaiser windowed sinc, beta 8 gives about 80 dB of stopband rejection
+HalfBandDecimator::HalfBandDecimator()
+{
+    const double beta = 8.0;
+    double sum = 0.0;
+
+    for (int j = 0; j < numCoefficients; j++)
+    {
+        double offset = 2 * j + 1;
+        double x = juce::MathConstants<double>::pi * offset / 2.0;
+        double ratio = offset / (centre + 1);
+        double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+
+        coefficients[j] = (float) (0.5 * std::sin(x) / x * window);
+        sum += 2.0 * coefficients[j];
+    }
+
+    // unity gain at DC, the centre tap supplies the other half
+    for (auto& c : coefficients)
+        c = (float) (c * 0.5 / sum);
+}
+
+void HalfBandDecimator::prepare(int maxInputSamples)
+{
+    history.assign((size_t) (numTaps - 1 + maxInputSamples), 0.0f);
+    evens.assign(history.size() / 2, 0.0f);
+    odds.assign(history.size() / 2, 0.0f);
+}
+
+void HalfBandDecimator::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+}
+
+void HalfBandDecimator::process(const float* input, int numInputSamples, float* output)
+{
+   #if FLEDGE_CPU_DISPATCH
+    switch (CpuDispatch::getTarget())
+    {
+        case CpuDispatch::Target::avx2:
+            processAVX2(input, numInputSamples, output);
+            return;
+        default:
+            break;
+    }
+   #endif
+
+    processBaseline(input, numInputSamples, output);
+}
+
+#if FLEDGE_CPU_DISPATCH
+// Output i has its centre tap at odd sample 2i + centre and every other tap at an even
+// sample, so split by phase the taps of consecutive outputs are consecutive too and
+// eight outputs fill one register
+FLEDGE_TARGET_AVX2 void HalfBandDecimator::processAVX2(const float* input, int numInputSamples, float* output)
+{
+    jassert(numInputSamples % 2 == 0 && numInputSamples + numTaps - 1 <= (int) history.size());
+
+    float* x = history.data();
+    std::copy(input, input + numInputSamples, x + numTaps - 1);
+
+    const int numOutputs = numInputSamples / 2;
+    const int numPairs = numOutputs + (numTaps - 1) / 2;
+    float* e = evens.data();
+    float* o = odds.data();
+
+    for (int m = 0; m < numPairs; m++)
+    {
+        e[m] = x[2 * m];
+        o[m] = x[2 * m + 1];
+    }
+
+    // odd sample centre is odds[i + half], the taps either side evens[i + half - j] and evens[i + half + 1 + j]
+    constexpr int half = centre / 2;
+    int i = 0;
+
+    for (; i + 8 <= numOutputs; i += 8)
+    {
+        __m256 sum = _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_loadu_ps(o + i + half));
+
+        for (int j = 0; j < numCoefficients; j++)
+        {
+            __m256 pair = _mm256_add_ps(_mm256_loadu_ps(e + i + half - j), _mm256_loadu_ps(e + i + half + 1 + j));
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(coefficients[j]), pair, sum);
+        }
+
+        _mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_loadu_ps(output + i), sum));
+    }
+
+    for (; i < numOutputs; i++)
+    {
+        float sum = 0.5f * o[i + half];
+        for (int j = 0; j < numCoefficients; j++)
+            sum += coefficients[j] * (e[i + half - j] + e[i + half + 1 + j]);
+        output[i] += sum;
+    }
+
+    std::copy(x + numInputSamples, x + numInputSamples + numTaps - 1, x);
+}
+#endif
+
+void HalfBandDecimator::processBaseline(const float* input, int numInputSamples, float* output)
+{
+    jassert(numInputSamples % 2 == 0 && numInputSamples + numTaps - 1 <= (int) history.size());
+
+    float* x = history.data();
+    std::copy(input, input + numInputSamples, x + numTaps - 1);
+
+    for (int i = 0; i < numInputSamples / 2; i++)
+    {
+        const float* centreTap = x + 2 * i + centre;
+        float sum = 0.5f * centreTap[0];
+
+        for (int j = 0; j < numCoefficients; j++)
+            sum += coefficients[j] * (centreTap[-(2 * j + 1)] + centreTap[2 * j + 1]);
+
+        output[i] += sum;
+    }
+
+    std::copy(x + numInputSamples, x + numInputSamples + numTaps - 1, x);
+}
+
+void Oversampler::prepare(int maxBaseSamples)
+{
+    for (int stage = 0; stage <= maxStages; stage++)
+    {
+        buses[stage].assign((size_t) (maxBaseSamples << stage), 0.0f);
+        delayLines[stage].assign((size_t) (getAlignmentDelay(stage) + (maxBaseSamples << stage)), 0.0f);
+    }
+
+    for (int stage = 0; stage < maxStages; stage++)
+        decimators[stage].prepare(maxBaseSamples << (stage + 1));
+}
+
+void Oversampler::reset()
+{
+    for (auto& decimator : decimators)
+        decimator.reset();
+    
+    for (auto& line : delayLines)
+        std::fill(line.begin(), line.end(), 0.0f);
+}
+
+void Oversampler::clear(int numBaseSamples, int numStages)
+{
+    for (int stage = 0; stage <= numStages; stage++)
+        juce::FloatVectorOperations::clear(buses[stage].data(), numBaseSamples << stage);
+}
+
+void Oversampler::decimate(int numBaseSamples, int numStages, bool alignStages)
+{
+    if (alignStages)
+        delay(numStages, numBaseSamples << numStages);
+    
+    for (int stage = numStages; stage > 0; stage--)
+    {
+        // delay what was rendered at this rate before the stage above is folded in
+        if (alignStages)
+            delay(stage - 1, numBaseSamples << (stage - 1));
+        
+        decimators[stage - 1].process(buses[stage].data(), numBaseSamples << stage, buses[stage - 1].data());
+    }
+}
+
+void Oversampler::delay(int stage, int numSamples)
+{
+    const int length = getAlignmentDelay(stage);
+    float* bus = buses[stage].data();
+    float* line = delayLines[stage].data();
+    
+    std::copy(bus, bus + numSamples, line + length);
+    std::copy(line, line + numSamples, bus);
+    std::copy(line + numSamples, line + numSamples + length, line);
+}
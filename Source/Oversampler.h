@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+    Created: 18 Oct 2026 6:03:19pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "CpuDispatch.h"
+
+// 2:1 half-band lowpass and decimator. Every other tap of a half-band filter is
+// zero, so only the odd phase is convolved and the even phase is the centre tap.
+class HalfBandDecimator
+{
+public:
+    static constexpr int numCoefficients = 12;                     // distinct nonzero taps per side
+    static constexpr int centre = 2 * numCoefficients - 1;
+    static constexpr int numTaps = 2 * centre + 1;                 // 47
+
+    HalfBandDecimator();
+
+    void prepare(int maxInputSamples);
+    void reset();
+
+    // filters numInputSamples (even) and adds numInputSamples / 2 to output
+    void process(const float* input, int numInputSamples, float* output);
+
+private:
+    void processBaseline(const float* input, int numInputSamples, float* output);
+   #if FLEDGE_CPU_DISPATCH
+    void processAVX2(const float* input, int numInputSamples, float* output);
+   #endif
+
+    std::array<float, numCoefficients> coefficients;
+    std::vector<float> history; // numTaps - 1 samples of state followed by the input
+    std::vector<float> evens, odds; // history split by phase, every tap then reads consecutive samples
+};
+
+// Renders happen at up to 8x into one bus per rate. Bus k runs at 2^k times the
+// base rate and is folded down into bus k - 1, so a single decimation cascade
+// serves all voices no matter how many were rendered into it.
+class Oversampler
+{
+public:
+    static constexpr int maxStages = 3;
+    static inline const juce::StringArray factorNames { "Off", "2x", "4x", "8x", "Adaptive" };
+    static constexpr int adaptive = maxStages + 1; // index of "Adaptive" in factorNames
+
+    void prepare(int maxBaseSamples);
+    void reset();
+
+    float* getBus(int stage) { return buses[(size_t) stage].data(); }
+
+    void clear(int numBaseSamples, int numStages);
+
+    // leaves the whole mix at the base rate in bus 0. With alignStages every bus
+    // is delayed so its content comes out with the same latency, voices can then
+    // move between rates without jumping in time
+    void decimate(int numBaseSamples, int numStages, bool alignStages);
+
+    // latency in base rate samples when stages are aligned
+    static constexpr int alignedLatency = HalfBandDecimator::centre + 1;
+
+    // latency in base rate samples for the host. Unaligned, each decimator delays by
+    // centre samples at its input rate, which adds up to a fraction of a base sample
+    static int getLatency(int numStages, bool alignStages)
+    {
+        if (alignStages)
+            return alignedLatency;
+        return juce::roundToInt(HalfBandDecimator::centre * (1.0 - 1.0 / (1 << numStages)));
+    }
+
+private:
+    // bus k is delayed by 2^k + centre of its own samples, which adds up to
+    // alignedLatency after the k decimators of centre / 2^j samples each
+    static constexpr int getAlignmentDelay(int stage) { return (1 << stage) + HalfBandDecimator::centre; }
+
+    void delay(int stage, int numSamples);
+
+    std::array<std::vector<float>, maxStages + 1> buses;
+    std::array<std::vector<float>, maxStages + 1> delayLines; // alignment delay followed by the block
+    std::array<HalfBandDecimator, maxStages> decimators;
+};
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    ParameterChanges.h
+    Created: 18 Oct 2026 4:05:37pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <bitset>
+
+// Changed flags by parameter index. Parameter listeners mark from any thread,
+// the audio thread takes every pending change once per block without locking.
+class ParameterChanges
+{
+public:
+    static constexpr int maxParameters = 256;
+    using Set = std::bitset<maxParameters>;
+
+    void markChanged(int index)
+    {
+        jassert(index >= 0 && index < maxParameters);
+        words[(size_t) index / 64].fetch_or(juce::uint64(1) << (index % 64));
+    }
+
+    void markAll()
+    {
+        for (auto& word : words)
+            word.store(~juce::uint64(0));
+    }
+
+    Set takeChanges()
+    {
+        Set changes;
+        for (size_t w = 0; w < words.size(); w++)
+            changes |= Set(words[w].exchange(0)) << (w * 64);
+        return changes;
+    }
+
+private:
+    std::array<std::atomic<juce::uint64>, maxParameters / 64> words {};
+};
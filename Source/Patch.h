@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    Patch.h
+    Created: 18 Oct 2026 5:12:48pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SineEngine.h"
+#include "Envelope.h"
+#include "Routing.h"
+#include "Glide.h"
+#include "NoteExpression.h"
+#include "Tuning.h"
+
+// One set of sound parameters per plugin instance. Voices never copy it, they
+// read the patch and the per block control values derived from it.
+struct OperatorPatch
+{
+    static inline const juce::StringArray modeNames { "Ratio", "Fixed" };
+    
+    Envelope::Parameters envelope;
+    float ratio = 1.0f;
+    float fixed = 20.0f;
+    bool isFixed = false;
+    float modIndex = 0.0f;
+};
+
+struct Patch
+{
+    std::array<OperatorPatch, Routing::maxOperators> op;
+    std::array<int, Routing::maxOperators> operatorRouting {};
+    int outputRouting = 0;
+    int numOperators = 4; // one of Routing::operatorCounts
+    Glide::Settings glide;
+    float bendRange = 2.0f; // semitones either way at full pitch wheel
+    float modWheelDepth = 2.0f; // modulation index added at full mod wheel
+    NoteExpression::Settings expression;
+    Tuning::Table tuning = Tuning::equalTemperament();
+    Sine::Mode sineMode = Sine::Mode::exact;
+    int oversamplingStages = 0; // voices render at 2^stages times the sample rate
+    bool isOversamplingAdaptive = false; // each voice picks up to oversamplingStages itself
+};
+
+// start and end of a control value over one block
+struct Ramp { float start, end; };
+
+struct OperatorControls
+{
+    Ramp ratio, fixed, modIndex;
+    bool isFixed;
+};
+
+using PatchControls = std::array<OperatorControls, Routing::maxOperators>;
+
+// Smooths the patch values once per block for every voice, along with the pitch
+// wheel and mod wheel which act on all of them.
+class PatchSmoother
+{
+public:
+    void prepareToPlay(double sampleRate, const Patch& patch)
+    {
+        pitchBend.reset(sampleRate, performanceTime);
+        modWheel.reset(sampleRate, performanceTime);
+        
+        for (int i = 0; i < Routing::maxOperators; i++)
+        {
+            auto& s = smoothed[i];
+            s.ratio.reset(sampleRate, 0.001);
+            s.fixed.reset(sampleRate, 0.001);
+            s.modIndex.reset(sampleRate, 0.001);
+
+            s.ratio.setCurrentAndTargetValue(patch.op[i].ratio);
+            s.fixed.setCurrentAndTargetValue(patch.op[i].fixed);
+            s.modIndex.setCurrentAndTargetValue(patch.op[i].modIndex);
+        }
+    }
+
+    void setTargets(const Patch& patch)
+    {
+        for (int i = 0; i < Routing::maxOperators; i++)
+        {
+            smoothed[i].ratio.setTargetValue(patch.op[i].ratio);
+            smoothed[i].fixed.setTargetValue(patch.op[i].fixed);
+            smoothed[i].modIndex.setTargetValue(patch.op[i].modIndex);
+        }
+    }
+
+    // bend from -1 to 1, wheel from 0 to 1
+    void setPitchBend(float bend) { pitchBend.setTargetValue(bend); }
+    void setModWheel(float wheel) { modWheel.setTargetValue(wheel); }
+
+    // bendRatio is what the pitch wheel multiplies note frequencies by
+    void advance(PatchControls& controls, Ramp& bendRatio, const Patch& patch, int numSamples)
+    {
+        Ramp wheel { modWheel.getCurrentValue(), modWheel.skip(numSamples) };
+        wheel = { wheel.start * patch.modWheelDepth, wheel.end * patch.modWheelDepth };
+
+        for (int i = 0; i < Routing::maxOperators; i++)
+        {
+            auto& s = smoothed[i];
+            auto& c = controls[i];
+            c.ratio = { s.ratio.getCurrentValue(), s.ratio.skip(numSamples) };
+            c.fixed = { s.fixed.getCurrentValue(), s.fixed.skip(numSamples) };
+            c.modIndex = { s.modIndex.getCurrentValue() + wheel.start, s.modIndex.skip(numSamples) + wheel.end };
+            c.isFixed = patch.op[i].isFixed;
+        }
+
+        // no pow while the wheel rests at the centre
+        Ramp bend { pitchBend.getCurrentValue(), pitchBend.skip(numSamples) };
+        if (bend.start == 0.0f && bend.end == 0.0f)
+            bendRatio = { 1.0f, 1.0f };
+        else
+            bendRatio = { std::exp2(bend.start * patch.bendRange / 12.0f), std::exp2(bend.end * patch.bendRange / 12.0f) };
+    }
+
+private:
+    static constexpr double performanceTime = 0.005; // seconds, wheels are coarser than parameters
+
+    struct Smoothed
+    {
+        juce::SmoothedValue<float> ratio, fixed, modIndex;
+    };
+
+    std::array<Smoothed, Routing::maxOperators> smoothed;
+    juce::SmoothedValue<float> pitchBend, modWheel;
+};
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    Phase.h
+    Created: 18 Oct 2026 10:18:36pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Operator phase as unsigned 32 bit fixed point, one cycle is 2^32. The
+// accumulator wraps by overflowing, so there is no branch or floor in the
+// oscillator and every platform produces the same phase bits. SIMDRegister
+// has no conversions between its float and integer forms, the two needed here
+// use the native registers and fall back to one lane at a time elsewhere.
+namespace Phase
+{
+    constexpr double cycle = 4294967296.0;
+
+    template <typename Vec>
+    using Bits = typename Vec::vMaskType;
+
+    // nearest fixed point value for a phase or increment in cycles, wrapped into one cycle
+    inline juce::uint32 fromCycles(double cycles)
+    {
+        return (juce::uint32) (juce::int64) std::llround((cycles - std::floor(cycles)) * cycle);
+    }
+
+    // two's complement step for a ramp that may go down, at most half a cycle either way
+    inline juce::uint32 stepFromCycles(double cycles)
+    {
+        return (juce::uint32) (juce::int32) std::llround(juce::jlimit(-0.5, 0.5, cycles) * cycle);
+    }
+
+    // the phase in cycles between -0.5 and 0.5, exact to 24 bits
+    template <typename Vec>
+    inline Vec toSignedCycles(Bits<Vec> phase)
+    {
+        constexpr float scale = (float) (1.0 / cycle);
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if constexpr (std::is_same<Vec, juce::dsp::SIMDRegister<float>>::value)
+            return Vec::fromNative(_mm_mul_ps(_mm_cvtepi32_ps(phase.value), _mm_set1_ps(scale)));
+       #elif JUCE_USE_ARM_NEON
+        if constexpr (std::is_same<Vec, juce::dsp::SIMDRegister<float>>::value)
+            return Vec::fromNative(vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(phase.value)), scale));
+       #endif
+
+        Vec result;
+        for (size_t lane = 0; lane < Vec::size(); lane++)
+            result.set(lane, (float) (juce::int32) phase.get(lane) * scale);
+        return result;
+    }
+
+    // phase bits for any number of cycles within int range, whole cycles drop out
+    template <typename Vec>
+    inline Bits<Vec> wrapCycles(Vec cycles)
+    {
+        constexpr float scale = (float) cycle;
+
+        // within half a cycle of zero, exactly +0.5 converts to the bits of -0.5 which is the same phase
+        auto offset = cycles - Vec::truncate(cycles);
+        offset -= Vec::expand(1.0f) & Vec::greaterThan(offset, Vec::expand(0.5f));
+        offset += Vec::expand(1.0f) & Vec::lessThan(offset, Vec::expand(-0.5f));
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if constexpr (std::is_same<Vec, juce::dsp::SIMDRegister<float>>::value)
+            return Bits<Vec>::fromNative(_mm_cvttps_epi32(_mm_mul_ps(offset.value, _mm_set1_ps(scale))));
+       #elif JUCE_USE_ARM_NEON
+        if constexpr (std::is_same<Vec, juce::dsp::SIMDRegister<float>>::value)
+            return Bits<Vec>::fromNative(vreinterpretq_u32_s32(vcvtq_s32_f32(vmulq_n_f32(offset.value, scale))));
+       #endif
+
+        Bits<Vec> result;
+        for (size_t lane = 0; lane < Vec::size(); lane++)
+            result.set(lane, (juce::uint32) (juce::int64) (offset.get(lane) * scale));
+        return result;
+    }
+}
@@ -38,6 +38,14 @@ FledgeAudioProcessorEditor::FledgeAudioProcessorEditor (FledgeAudioProcessor& p)
 
     addAndMakeVisible(practiceSlider);
     
+    cpuTargetLabel.setText("DSP: " + CpuDispatch::getTargetName(), juce::dontSendNotification);
+    cpuTargetLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(cpuTargetLabel);
+    
+    tuningButton.setButtonText("Tuning: " + audioProcessor.getTuning().getName());
+    tuningButton.addListener(this);
+    addAndMakeVisible(tuningButton);
+    
     setSize (800, 800);
 }
 
@@ -49,6 +57,7 @@ FledgeAudioProcessorEditor::~FledgeAudioProcessorEditor()
     }
     showWaveformButton.removeListener(this);
     showAlgorithmButton.removeListener(this);
+    tuningButton.removeListener(this);
 
     
 }
@@ -75,5 +84,52 @@ void FledgeAudioProcessorEditor::resized()
     
     showWaveformButton.setBounds(20, 570, 140, 40);
     showAlgorithmButton.setBounds(160, 570, 140, 40);
+    tuningButton.setBounds(20, 730, 280, 30);
+    cpuTargetLabel.setBounds(20, 770, 280, 20);
 
 }
+
+void FledgeAudioProcessorEditor::showTuningMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem("Load Scala Files...", [this]
+    {
+        // a scale, optionally with its keyboard mapping
+        tuningChooser = std::make_unique<juce::FileChooser>("Choose a .scl file and optionally a .kbm file", juce::File(), "*.scl;*.kbm");
+        
+        auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles | juce::FileBrowserComponent::canSelectMultipleItems;
+        tuningChooser->launchAsync(flags, [this](const juce::FileChooser& chooser)
+        {
+            loadTuning(chooser.getResults());
+        });
+    });
+    
+    menu.addItem("Equal Temperament", [this]
+    {
+        audioProcessor.getTuning().resetToEqualTemperament();
+        tuningButton.setButtonText("Tuning: " + audioProcessor.getTuning().getName());
+    });
+    
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&tuningButton));
+}
+
+void FledgeAudioProcessorEditor::loadTuning(const juce::Array<juce::File>& files)
+{
+    juce::File scaleFile, keyboardMappingFile;
+    for (const auto& file : files)
+    {
+        if (file.hasFileExtension("scl"))
+            scaleFile = file;
+        else if (file.hasFileExtension("kbm"))
+            keyboardMappingFile = file;
+    }
+    
+    if (scaleFile == juce::File())
+        return;
+    
+    auto result = audioProcessor.getTuning().loadScala(scaleFile, keyboardMappingFile);
+    if (result.failed())
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Can't load the tuning", result.getErrorMessage());
+    
+    tuningButton.setButtonText("Tuning: " + audioProcessor.getTuning().getName());
+}
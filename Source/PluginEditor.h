@@ -13,6 +13,7 @@
 #include "UserInterface.h"
 #include "AlgorithmGraphics.h"
 #include "LookAndFeel.h"
+#include "CpuDispatch.h"
 
 //==============================================================================
 /**
@@ -64,11 +65,17 @@ public:
             waveformDisplay.setVisible(false);
             algorithmGraphics.setVisible(true);
             algorithmSelector.setVisible(true);
+            
+        } else if (buttonClicked == &tuningButton) {
+            showTuningMenu();
         }
     }
 
 
 private:
+    void showTuningMenu();
+    void loadTuning(const juce::Array<juce::File>& files);
+    
  //   TextBoxSlider laf;
     PracticeDialGraphics practiceLookAndFeel;
     juce::Slider practiceSlider;
@@ -80,6 +87,9 @@ private:
     WaveformDisplayGraphics waveformDisplay;
     AlgorithmGraphics algorithmGraphics;
     AlgorithmSelectInterface algorithmSelector;
+    juce::Label cpuTargetLabel;
+    juce::TextButton tuningButton;
+    std::unique_ptr<juce::FileChooser> tuningChooser;
     FledgeAudioProcessor& audioProcessor;
 
     
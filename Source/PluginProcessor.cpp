@@ -9,6 +9,8 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "VoiceProcessor.h"
+#include "Benchmark.h"
+#include "Presets.h"
 
 //==============================================================================
 FledgeAudioProcessor::FledgeAudioProcessor()
@@ -24,9 +26,63 @@ FledgeAudioProcessor::FledgeAudioProcessor()
 #endif
 {
     const auto params = this->getParameters();
+    jassert(params.size() <= ParameterChanges::maxParameters);
+    
     for (auto param : params){
+        setParameterValue(param->getParameterIndex(), param->getValue());
         param->addListener(this);
     }
+    
+    // the whole pool is allocated here, polyphony only limits how much of it is used
+    for (int v = 0; v < FledgeSynthesiser::maxVoices; v++)
+        synth.addVoice(new SynthVoice());
+    
+    synth.addSound(new SynthSound());
+    synth.setNoteStealingEnabled(true);
+    
+    globalAttack = getParameterPointer("globalAttack", globalEnvelopeMask);
+    globalDecay = getParameterPointer("globalDecay", globalEnvelopeMask);
+    globalSustain = getParameterPointer("globalSustain", globalEnvelopeMask);
+    globalRelease = getParameterPointer("globalRelease", globalEnvelopeMask);
+    outputRouting = getParameterPointer("outputRoutingMask", routingMask);
+    operatorCount = getParameterPointer("operatorCount", routingMask);
+    sineMode = getParameterPointer("sineMode", sineModeMask);
+    oversampling = getParameterPointer("oversampling", oversamplingMask);
+    polyphony = getParameterPointer("polyphony", voicingMask);
+    voiceMode = getParameterPointer("voiceMode", voicingMask);
+    stealPolicy = getParameterPointer("stealPolicy", voicingMask);
+    multithreading = getParameterPointer("multithreading", voicingMask);
+    glideTime = getParameterPointer("port", glideMask);
+    glideMode = getParameterPointer("glideMode", glideMask);
+    glideShape = getParameterPointer("glideShape", glideMask);
+    bendRange = getParameterPointer("bendRange", performanceMask);
+    modWheelDepth = getParameterPointer("modWheelDepth", performanceMask);
+    mpe = getParameterPointer("mpe", performanceMask);
+    mpeBendRange = getParameterPointer("mpeBendRange", performanceMask);
+    pressureDepth = getParameterPointer("pressureDepth", performanceMask);
+    slideDepth = getParameterPointer("slideDepth", performanceMask);
+    
+    for (int oper = 0; oper < Routing::maxOperators; oper++)
+    {
+        auto& p = operatorParameters[oper];
+        juce::String index = juce::String(oper);
+        
+        p.attack = getParameterPointer("attack" + index, p.envelopeMask);
+        p.decay = getParameterPointer("decay" + index, p.envelopeMask);
+        p.sustain = getParameterPointer("sustain" + index, p.envelopeMask);
+        p.release = getParameterPointer("release" + index, p.envelopeMask);
+        p.loop = getParameterPointer("loop" + index, p.envelopeMask);
+        
+        p.ratio = getParameterPointer("ratio" + index, p.operatorMask);
+        p.fixed = getParameterPointer("fixed" + index, p.operatorMask);
+        p.mode = getParameterPointer("opMode" + index, p.operatorMask);
+        p.modIndex = getParameterPointer("amplitude" + index, p.operatorMask);
+        p.routing = getParameterPointer("operator" + index + "RoutingMask", routingMask);
+    }
+    
+   #if FLEDGE_BENCHMARK
+    juce::Logger::writeToLog(Benchmark::run());
+   #endif
 }
 
 FledgeAudioProcessor::~FledgeAudioProcessor()
@@ -102,13 +158,10 @@ void FledgeAudioProcessor::changeProgramName (int index, const juce::String& new
 //==============================================================================
 void FledgeAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-
-    for (int v = 0; v < 8; v++)
-        synth.addVoice(new SynthVoice());
+    Sine::Table::getTable(); // build the sine table off the audio thread
     
-    synth.addSound(new SynthSound());
-    synth.setNoteStealingEnabled(true);
-    synth.setCurrentPlaybackSampleRate(sampleRate);
+    synth.allNotesOff(0, false);
+    synth.prepareToPlay(sampleRate, samplesPerBlock);
     
     for (int v = 0; v < synth.getNumVoices(); v++)
     {
@@ -117,6 +170,10 @@ void FledgeAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
             voice->prepareToPlay(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
         }
     }
+    
+    // fresh voices haven't seen any parameter yet, and hosts ask for the latency before the first block
+    parameterChanges.markAll();
+    updateParameters();
 }
 
 void FledgeAudioProcessor::releaseResources()
@@ -147,52 +204,152 @@ bool FledgeAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 #endif
 
 void FledgeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages);
+}
+
+void FledgeAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void FledgeAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-        
     
-    float globalAttack = apvts.getRawParameterValue("globalAttack")->load();
-    float globalDecay = apvts.getRawParameterValue("globalDecay")->load();
-    float globalSustain = apvts.getRawParameterValue("globalSustain")->load();
-    float globalRelease = apvts.getRawParameterValue("globalRelease")->load();
+    // learned controllers move their parameters before the patch is rebuilt, the synth
+    // still sees every message itself
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+        if (message.isController())
+            midiLearn.handleController(message.getControllerNumber(), message.getControllerValue());
+    }
     
-    for (int oper = 0; oper < 4; oper++){
-        juce::String attackID = "attack" + juce::String(oper);
-        juce::String decayID = "decay" + juce::String(oper);
-        juce::String sustainID = "sustain" + juce::String(oper);
-        juce::String releaseID = "release" + juce::String(oper);
+    midiLearn.advance(buffer.getNumSamples(), getSampleRate(), [this] (int parameterIndex, float value)
+    {
+        setParameterValue(parameterIndex, value);
+    });
+    
+    updateParameters();
+    
+    synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+    
+}
+
+std::atomic<float>* FledgeAudioProcessor::getParameterPointer(const juce::String& parameterID, ParameterChanges::Set& mask)
+{
+    auto* parameter = apvts.getParameter(parameterID);
+    jassert(parameter != nullptr);
+    
+    mask.set((size_t) parameter->getParameterIndex());
+    return &parameterValues[(size_t) parameter->getParameterIndex()];
+}
 
-        float attack = apvts.getRawParameterValue(attackID)->load();
-        float decay = apvts.getRawParameterValue(decayID)->load();
-        float sustain = apvts.getRawParameterValue(sustainID)->load();
-        float release = apvts.getRawParameterValue(releaseID)->load();
+// every parameter comes from the value tree state, so they are all ranged
+void FledgeAudioProcessor::setParameterValue(int parameterIndex, float normalisedValue)
+{
+    auto* parameter = static_cast<juce::RangedAudioParameter*>(getParameters()[parameterIndex]);
+    parameterValues[(size_t) parameterIndex].store(parameter->convertFrom0to1(normalisedValue));
+    parameterChanges.markChanged(parameterIndex);
+}
 
-        juce::String ratioID = "ratio" + juce::String(oper);
-        juce::String fixedID = "fixed" + juce::String(oper);
-        juce::String modIndexID = "amplitude" + juce::String(oper);
-        juce::String operatorRoutingID = "operator" + juce::String(oper) + "Routing";
+void FledgeAudioProcessor::parameterValueChanged (int parameterIndex, float newValue)
+{
+    // a learned controller moving its parameter, the audio thread has it further along already
+    if (midiLearn.isPublishing(parameterIndex) && juce::MessageManager::existsAndIsCurrentThread())
+        return;
 
-        float ratio = apvts.getRawParameterValue(ratioID)->load();
-        float fixed = apvts.getRawParameterValue(fixedID)->load();
-        float modIndex = apvts.getRawParameterValue(modIndexID)->load();
-        float routing = apvts.getRawParameterValue(operatorRoutingID)->load();
+    setParameterValue(parameterIndex, getParameters()[parameterIndex]->getValue());
+}
 
-        for (int v = 0; v < synth.getNumVoices(); v++)
+// rebuilds only the parts of the patch whose parameters changed since the last block
+void FledgeAudioProcessor::updateParameters()
+{
+    // a newly loaded tuning is copied straight into the patch
+    bool tuningChanged = tuning.takeTable(patch.tuning);
+    
+    auto changes = parameterChanges.takeChanges();
+    if (changes.none() && ! tuningChanged)
+        return;
+    
+    bool globalEnvelopeChanged = (changes & globalEnvelopeMask).any();
+    
+    float attackScale = std::pow(2.0f, globalAttack->load() / 100.0f);
+    float decayScale = std::pow(2.0f, globalDecay->load() / 100.0f);
+    float sustainScale = std::pow(2.0f, globalSustain->load() / 100.0f);
+    float releaseScale = std::pow(2.0f, globalRelease->load() / 100.0f);
+    
+    for (int oper = 0; oper < Routing::maxOperators; oper++)
+    {
+        const auto& p = operatorParameters[oper];
+        auto& op = patch.op[oper];
+        
+        if (globalEnvelopeChanged || (changes & p.envelopeMask).any())
         {
-            if(auto voice = dynamic_cast<SynthVoice*>(synth.getVoice(v)))
-            {
-                voice->setEnvelope(oper, attack, decay, sustain/100.0f, release,
-                                   globalAttack, globalDecay, globalSustain, globalRelease);
-                voice->setFMParameters(oper, ratio, fixed, false, modIndex);
-                voice->setOperatorGain(oper, routing);
-                levelAtomic.store(voice->getOutputSample());
-            }
+            op.envelope.attack = attackScale * p.attack->load();
+            op.envelope.decay = decayScale * p.decay->load();
+            op.envelope.sustain = juce::jlimit(0.0f, 1.0f, sustainScale * p.sustain->load() / 100.0f);
+            op.envelope.release = releaseScale * p.release->load();
+            op.envelope.isLooping = p.loop->load() > 0.5f;
+        }
+        
+        if ((changes & p.operatorMask).any())
+        {
+            op.ratio = p.ratio->load();
+            op.fixed = p.fixed->load();
+            op.isFixed = p.mode->load() > 0.5f;
+            op.modIndex = p.modIndex->load();
         }
     }
-     
     
-    synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+    if ((changes & routingMask).any())
+    {
+        for (int oper = 0; oper < Routing::maxOperators; oper++)
+            patch.operatorRouting[oper] = (int) operatorParameters[oper].routing->load();
+        
+        patch.outputRouting = (int) outputRouting->load();
+        patch.numOperators = Routing::operatorCounts[(size_t) operatorCount->load()];
+    }
+    
+    if ((changes & sineModeMask).any())
+        patch.sineMode = (Sine::Mode) (int) sineMode->load();
+    
+    if ((changes & voicingMask).any())
+    {
+        synth.setPolyphony((int) polyphony->load());
+        synth.setStealPolicy((VoiceAllocator::StealPolicy) (int) stealPolicy->load());
+        synth.setVoiceMode((FledgeSynthesiser::VoiceMode) (int) voiceMode->load());
+        synth.setMultithreaded(multithreading->load() > 0.5f);
+    }
+    
+    if ((changes & glideMask).any())
+    {
+        patch.glide.time = glideTime->load();
+        patch.glide.mode = (Glide::Mode) (int) glideMode->load();
+        patch.glide.shape = (Glide::Shape) (int) glideShape->load();
+    }
+    
+    if ((changes & performanceMask).any())
+    {
+        patch.bendRange = bendRange->load();
+        patch.modWheelDepth = modWheelDepth->load();
+        patch.expression.isMpe = mpe->load() > 0.5f;
+        patch.expression.bendRange = mpeBendRange->load();
+        patch.expression.pressureDepth = pressureDepth->load();
+        patch.expression.slideDepth = slideDepth->load();
+    }
     
+    if ((changes & oversamplingMask).any())
+    {
+        int choice = (int) oversampling->load();
+        patch.isOversamplingAdaptive = choice == Oversampler::adaptive;
+        patch.oversamplingStages = patch.isOversamplingAdaptive ? Oversampler::maxStages : choice;
+        setLatencySamples(Oversampler::getLatency(patch.oversamplingStages, patch.isOversamplingAdaptive));
+    }
+    
+    synth.setPatch(patch);
 }
 
 //==============================================================================
@@ -209,7 +366,10 @@ juce::AudioProcessorEditor* FledgeAudioProcessor::createEditor()
 //==============================================================================
 void FledgeAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    copyXmlToBinary(*apvts.copyState().createXml(), destData);
+    auto xml = apvts.copyState().createXml();
+    xml->addChildElement(midiLearn.createXml().release());
+    xml->addChildElement(tuning.createXml().release());
+    copyXmlToBinary(*xml, destData);
 }
 
 void FledgeAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -217,6 +377,22 @@ void FledgeAudioProcessor::setStateInformation (const void* data, int sizeInByte
     const auto xmlState = getXmlFromBinary(data, sizeInBytes);
        if (xmlState == nullptr)
            return;
+
+       PresetManager::upgradeState(*xmlState);
+
+       // the controller map is saved alongside the parameters, not as one of them
+       if (auto* mappings = xmlState->getChildByName(MidiLearn::xmlTag))
+       {
+           midiLearn.restoreFromXml(*mappings);
+           xmlState->removeChildElement(mappings, true);
+       }
+
+       if (auto* tuningState = xmlState->getChildByName(Tuning::xmlTag))
+       {
+           tuning.restoreFromXml(*tuningState);
+           xmlState->removeChildElement(tuningState, true);
+       }
+
        const auto newTree = juce::ValueTree::fromXml(*xmlState);
        apvts.replaceState(newTree);
 }
@@ -232,8 +408,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout FledgeAudioProcessor::create
 {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "port", 1 }, "Glide", juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f), 0.0f));
-    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "port", 1 }, "Glide", juce::NormalisableRange<float>(0.0f, 5.0f, 0.001f, 0.3f), 0.0f));
+
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "globalAttack", 1 }, "Global Attack", juce::NormalisableRange<float>(-100.0f, 100.0f, 0.01f), 0.01f));
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "globalDecay", 1 }, "Global Decay", juce::NormalisableRange<float>(-100.0f, 100.0f, 0.01f), 0.2f));
@@ -242,7 +418,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout FledgeAudioProcessor::create
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "globalRelease", 1 }, "Global Release", juce::NormalisableRange<float>(-100.0f, 100.0f, 0.1f), 1.0f));
 
-    for (int oper = 0; oper < 4; oper++)
+    const int allRoutings = (1 << Routing::maxOperators) - 1;
+    
+    auto addOperator = [&layout, allRoutings] (int oper)
     {
         //******** Envelope Controls ********//
         juce::String attackID = "attack" + juce::String(oper);
@@ -279,7 +457,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout FledgeAudioProcessor::create
         juce::String opModeID = "opMode" + juce::String(oper);
         juce::String opModeName = "Mode " + juce::String(oper);
         
-        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { opModeID, 1 }, opModeName, juce::NormalisableRange<float>(20.0f, 20000.0f), 20.0f));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { opModeID, 1 }, opModeName, OperatorPatch::modeNames, 0));
 
         juce::String modIndexID = "amplitude" + juce::String(oper);
         juce::String modIndexName = "Modulation Amount " + juce::String(oper);
@@ -287,14 +465,69 @@ juce::AudioProcessorValueTreeState::ParameterLayout FledgeAudioProcessor::create
         layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { modIndexID, 1 }, modIndexName, juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f, 0.5f), 0.0f));
         
         //******** Operator Input ********//
-        juce::String operatorRoutingID = "operator" + juce::String(oper) + "Routing";
+        // new IDs since the masks grew from 4 to 8 bits, old automation would have meant other operators
+        juce::String operatorRoutingID = "operator" + juce::String(oper) + "RoutingMask";
         juce::String operatorRoutingName = "Operator " + juce::String(oper) + " Routing";
         
-        layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { operatorRoutingID, 1 }, operatorRoutingName, 0, 15, 0));
+        layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { operatorRoutingID, 1 }, operatorRoutingName, 0, allRoutings, 0));
+    };
+    
+    auto addLoop = [&layout] (int oper)
+    {
+        juce::String loopID = "loop" + juce::String(oper);
+        juce::String loopName = "Loop " + juce::String(oper);
         
+        layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { loopID, 1 }, loopName, false));
+    };
+    
+    // the first four operators and the output routing are where the original release had them
+    const int originalOperators = Routing::operatorCounts[0];
+    
+    for (int oper = 0; oper < originalOperators; oper++)
+        addOperator(oper);
+    
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { "outputRoutingMask", 1 }, "Output Routing", 0, allRoutings, 0));
+
+    // parameters added since are appended in the order they came, hosts that address
+    // parameters by index keep their automation on the ones above
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "sineMode", 1 }, "Oscillator Quality", Sine::modeNames, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "oversampling", 1 }, "Oversampling", Oversampler::factorNames, 0));
+    
+    for (int oper = 0; oper < originalOperators; oper++)
+        addLoop(oper);
+    
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { "polyphony", 1 }, "Polyphony", 1, FledgeSynthesiser::maxVoices, 8));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "voiceMode", 1 }, "Voice Mode", FledgeSynthesiser::voiceModeNames, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "stealPolicy", 1 }, "Voice Stealing", VoiceAllocator::stealPolicyNames, 3));
+    
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "multithreading", 1 }, "Multithreading", false));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "operatorCount", 1 }, "Operators", Routing::operatorCountNames, 0));
+    
+    for (int oper = originalOperators; oper < Routing::maxOperators; oper++)
+    {
+        addOperator(oper);
+        addLoop(oper);
     }
     
-    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { "outputRouting", 1 }, "Output Routing", 0, 15, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "glideMode", 1 }, "Glide Mode", Glide::modeNames, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "glideShape", 1 }, "Glide Shape", Glide::shapeNames, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { "bendRange", 1 }, "Pitch Bend Range", 0, 24, 2));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "modWheelDepth", 1 }, "Mod Wheel Depth", juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f, 0.5f), 2.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "mpe", 1 }, "MPE", false));
+    
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { "mpeBendRange", 1 }, "MPE Bend Range", 0, 96, 48));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "pressureDepth", 1 }, "Pressure Depth", juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f, 0.5f), 2.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "slideDepth", 1 }, "Slide Depth", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
 
     return layout;
 }
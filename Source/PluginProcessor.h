@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "VoiceProcessor.h"
+#include "ParameterChanges.h"
+#include "MidiLearn.h"
 
 //==============================================================================
 /**
@@ -30,6 +32,9 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+    bool supportsMPE() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -60,63 +65,50 @@ public:
     
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
-    void parameterValueChanged (int parameterIndex, float newValue) override
-    {
-        
-        if (auto* param = dynamic_cast<juce::AudioProcessorParameterWithID*>(this->getParameters()[parameterIndex]))
-        {
-            auto parameterID = param->getParameterID();
-            // do something with this
-        }
-
-    
-        /*
-        float globalAttack = apvts.getRawParameterValue("globalAttack")->load();
-        float globalDecay = apvts.getRawParameterValue("globalDecay")->load();
-        float globalSustain = apvts.getRawParameterValue("globalSustain")->load();
-        float globalRelease = apvts.getRawParameterValue("globalRelease")->load();
-        
-        for (int oper = 0; oper < 4; oper++){
-            juce::String attackID = "attack" + juce::String(oper);
-            juce::String decayID = "decay" + juce::String(oper);
-            juce::String sustainID = "sustain" + juce::String(oper);
-            juce::String releaseID = "release" + juce::String(oper);
-
-            float attack = apvts.getRawParameterValue(attackID)->load();
-            float decay = apvts.getRawParameterValue(decayID)->load();
-            float sustain = apvts.getRawParameterValue(sustainID)->load();
-            float release = apvts.getRawParameterValue(releaseID)->load();
-
-            juce::String ratioID = "ratio" + juce::String(oper);
-            juce::String fixedID = "fixed" + juce::String(oper);
-            juce::String modIndexID = "amplitude" + juce::String(oper);
-
-            float ratio = apvts.getRawParameterValue(ratioID)->load();
-            float fixed = apvts.getRawParameterValue(fixedID)->load();
-            float modIndex = apvts.getRawParameterValue(modIndexID)->load();
-
-            for (int v = 0; v < synth.getNumVoices(); v++)
-            {
-                if(auto voice = dynamic_cast<SynthVoice*>(synth.getVoice(v)))
-                {
-                    voice->setEnvelope(oper, attack, decay, sustain/100.0f, release,
-                                       globalAttack, globalDecay, globalSustain, globalRelease);
-                    voice->setFMParameters(oper, ratio, fixed, false, modIndex);
-                }
-            }
-        }
-         */
-    }
-    
+    void parameterValueChanged (int parameterIndex, float newValue) override;
     void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override {}
 
-    
+    MidiLearn& getMidiLearn() { return midiLearn; }
+    Tuning& getTuning() { return tuning; }
     
 private:
     float outputLevel;
     std::atomic<float> levelAtomic;
     
-    juce::Synthesiser synth;
+    FledgeSynthesiser synth;
+    
+    // raw values resolved once at construction, masks select each group's parameter indices
+    struct OperatorParameters
+    {
+        std::atomic<float>* attack, * decay, * sustain, * release, * loop;
+        std::atomic<float>* ratio, * fixed, * mode, * modIndex, * routing;
+        ParameterChanges::Set envelopeMask, operatorMask;
+    };
+    
+    std::array<OperatorParameters, Routing::maxOperators> operatorParameters;
+    std::atomic<float>* globalAttack, * globalDecay, * globalSustain, * globalRelease;
+    std::atomic<float>* outputRouting, * operatorCount, * sineMode, * oversampling;
+    std::atomic<float>* polyphony, * voiceMode, * stealPolicy, * multithreading;
+    std::atomic<float>* glideTime, * glideMode, * glideShape;
+    std::atomic<float>* bendRange, * modWheelDepth;
+    std::atomic<float>* mpe, * mpeBendRange, * pressureDepth, * slideDepth;
+    ParameterChanges::Set globalEnvelopeMask, routingMask, sineModeMask, oversamplingMask, voicingMask, glideMask, performanceMask;
+    
+    // what the patch is built from, by parameter index. The host's values, except that a
+    // learned controller gets here a few blocks before the host is told
+    std::array<std::atomic<float>, ParameterChanges::maxParameters> parameterValues {};
+    ParameterChanges parameterChanges;
+    MidiLearn midiLearn { *this };
+    Tuning tuning;
+    Patch patch;
+    
+    std::atomic<float>* getParameterPointer(const juce::String& parameterID, ParameterChanges::Set& mask);
+    void setParameterValue(int parameterIndex, float normalisedValue);
+    void updateParameters();
+    
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+    
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FledgeAudioProcessor)
 };
@@ -9,6 +9,7 @@
 */
 
 #include "Presets.h"
+#include "MidiLearn.h"
 
 const juce::File PresetManager::defaultDirectory { juce::File::getSpecialLocation(
     juce::File::SpecialLocationType::commonDocumentsDirectory)
@@ -18,6 +19,46 @@ const juce::File PresetManager::defaultDirectory { juce::File::getSpecialLocatio
 const juce::String PresetManager::extension { "preset" };
 const juce::String PresetManager::presetNameProperty { "presetName" };
 
+namespace
+{
+    // operator and output routings from before the masks grew to 8 bits
+    bool isFourBitRoutingID(const juce::String& id)
+    {
+        return id == "outputRouting" || (id.startsWith("operator") && id.endsWith("Routing"));
+    }
+}
+
+void PresetManager::upgradeState(juce::XmlElement& state)
+{
+    // states saved before glide worked have no glide mode
+    bool isBeforeGlide = true;
+    for (auto* parameter : state.getChildWithTagNameIterator("PARAM"))
+        if (parameter->getStringAttribute("id") == "glideMode")
+            isBeforeGlide = false;
+
+    for (auto* parameter : state.getChildWithTagNameIterator("PARAM"))
+    {
+        const auto id = parameter->getStringAttribute("id");
+
+        // port was an unused 0 to 100 then, those states never glided and load without it
+        if (id == "port" && isBeforeGlide)
+            parameter->setAttribute("value", 0.0);
+
+        // opMode used to be an unused frequency, states from then are all in ratio mode
+        if (id.startsWith("opMode") && parameter->getDoubleAttribute("value") > 1.0)
+            parameter->setAttribute("value", 0.0);
+
+        // the routings were renamed when they grew to 8 bits, saved values are plain so they carry over
+        if (isFourBitRoutingID(id))
+            parameter->setAttribute("id", id + "Mask");
+    }
+
+    if (auto* mappings = state.getChildByName(MidiLearn::xmlTag))
+        for (auto* mapping : mappings->getChildWithTagNameIterator("MAP"))
+            if (isFourBitRoutingID(mapping->getStringAttribute("parameter")))
+                mapping->setAttribute("parameter", mapping->getStringAttribute("parameter") + "Mask");
+}
+
 PresetManager::PresetManager(juce::AudioProcessorValueTreeState& apvts) : apvts(apvts)
 {
     if(!defaultDirectory.exists())
@@ -53,7 +94,12 @@ void PresetManager::loadPreset(const juce::String& presetName)
     }
     
     juce::XmlDocument xmlDocument { presetFile };
-    const auto valueTreeToLoad = juce::ValueTree::fromXml(*xmlDocument.getDocumentElement());
+    const auto xml = xmlDocument.getDocumentElement();
+    if (xml == nullptr)
+        return;
+    
+    upgradeState(*xml);
+    const auto valueTreeToLoad = juce::ValueTree::fromXml(*xml);
     
     apvts.replaceState(valueTreeToLoad);
     currentPreset.setValue(presetName);
@@ -19,6 +19,9 @@ public:
     static const juce::String presetNameProperty;
 
     PresetManager(juce::AudioProcessorValueTreeState& apvts);
+
+    // rewrites parameters saved by older versions, for presets and the plugin state alike
+    static void upgradeState(juce::XmlElement& state);
     ~PresetManager();
     
     void loadPreset(const juce::String& presetName);
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    Routing.cpp
+    Created: 18 Oct 2026 4:21:37pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "Routing.h"
+
+namespace
+{
+    int countBits(juce::uint32 bits)
+    {
+        int count = 0;
+        for (; bits != 0; bits &= bits - 1)
+            count++;
+        return count;
+    }
+}
+
+Routing::Schedule Routing::compile(const std::array<int, maxOperators>& operatorRouting, int outputRouting, int numOperators)
+{
+    jassert(numOperators > 0 && numOperators <= maxOperators);
+    const juce::uint32 allOperators = (1u << numOperators) - 1;
+    Schedule schedule;
+    schedule.numOperators = numOperators;
+
+    // walk back from the carriers to find every operator that can be heard
+    juce::uint32 active = (juce::uint32) outputRouting & allOperators;
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (int op = 0; op < numOperators; op++)
+        {
+            auto withSources = active | ((juce::uint32) operatorRouting[op] & allOperators);
+            if (((active >> op) & 1) && withSources != active)
+            {
+                active = withSources;
+                changed = true;
+            }
+        }
+    }
+    schedule.activeOperators = active;
+
+    // topological order, highest index first among ready operators to match the 3, 2, 1, 0 order
+    // of the original algorithm. When only cycles remain, the operator waiting on the fewest
+    // others goes next and those inputs become unit delays.
+    std::array<int, maxOperators> position {};
+    juce::uint32 scheduled = 0;
+    
+    while (scheduled != active)
+    {
+        int next = -1;
+        int fewestPending = numOperators + 1;
+        
+        for (int op = numOperators - 1; op >= 0; op--)
+        {
+            if (! ((active >> op) & 1) || ((scheduled >> op) & 1))
+                continue;
+            
+            auto pending = (juce::uint32) operatorRouting[op] & active & ~scheduled & ~(1u << op);
+            int numPending = countBits(pending);
+            if (numPending < fewestPending)
+            {
+                next = op;
+                fewestPending = numPending;
+            }
+        }
+        
+        position[next] = schedule.numSteps;
+        schedule.steps[schedule.numSteps++].op = next;
+        scheduled |= 1u << next;
+    }
+
+    std::array<int, maxOperators> level {};
+    for (int s = 0; s < schedule.numSteps; s++)
+    {
+        auto& step = schedule.steps[s];
+        for (int source = 0; source < numOperators; source++)
+        {
+            if ((operatorRouting[step.op] >> source) & 1)
+            {
+                step.sources[step.numSources] = source;
+                step.isDelayed[step.numSources] = position[source] >= s;
+                
+                if (! step.isDelayed[step.numSources])
+                    level[step.op] = juce::jmax(level[step.op], level[source] + 1);
+                
+                step.numSources++;
+            }
+        }
+        
+        schedule.levels[level[step.op]] |= 1u << step.op;
+        schedule.numLevels = juce::jmax(schedule.numLevels, level[step.op] + 1);
+    }
+
+    for (int op = 0; op < numOperators; op++)
+        if ((outputRouting >> op) & 1)
+            schedule.carriers[schedule.numCarriers++] = op;
+
+    return schedule;
+}
+
+Routing::Schedule Routing::withoutOperators(const Schedule& schedule, juce::uint32 operators)
+{
+    Schedule result = schedule;
+    result.numSteps = 0;
+    
+    for (int s = 0; s < schedule.numSteps; s++)
+        if (! ((operators >> schedule.steps[s].op) & 1))
+            result.steps[result.numSteps++] = schedule.steps[s];
+    
+    // levels left empty are dropped, the order of the rest still holds
+    result.levels = {};
+    result.numLevels = 0;
+    for (int l = 0; l < schedule.numLevels; l++)
+        if (auto level = schedule.levels[l] & ~operators)
+            result.levels[result.numLevels++] = level;
+    
+    return result;
+}
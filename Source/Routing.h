@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Routing.h
+    Created: 18 Oct 2026 4:21:37pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Compiles the routing parameters into the order operators are evaluated in.
+// Bit j of operator N's routing means operator j modulates N, bit j of the
+// output routing makes operator j a carrier.
+namespace Routing
+{
+    constexpr int maxOperators = 8;
+    
+    // operator counts a patch can have, the voice kernel is built once for each
+    constexpr std::array<int, 3> operatorCounts { 4, 6, 8 };
+    inline const juce::StringArray operatorCountNames { "4 Operators", "6 Operators", "8 Operators" };
+
+    struct Step
+    {
+        int op = 0;
+        int numSources = 0;
+        std::array<int, maxOperators> sources {};
+        
+        // the source is evaluated after this operator, so it reads the previous
+        // sample's output. Only happens on feedback and other real cycles.
+        std::array<bool, maxOperators> isDelayed {};
+    };
+
+    struct Schedule
+    {
+        std::array<Step, maxOperators> steps;
+        int numSteps = 0;
+        
+        std::array<int, maxOperators> carriers {};
+        int numCarriers = 0;
+        
+        // operators that reach a carrier, everything else is never evaluated
+        juce::uint32 activeOperators = 0;
+        
+        // operators whose undelayed sources are all in earlier levels. A level can be
+        // evaluated at once, so parallel carriers are one level and two stacks are two
+        std::array<juce::uint32, maxOperators> levels {};
+        int numLevels = 0;
+        
+        int numOperators = 4; // operators from this one up are never evaluated
+        
+        bool isActive(int op) const { return (activeOperators >> op) & 1; }
+    };
+
+    // only the first numOperators take part, routing bits of the others are ignored
+    Schedule compile(const std::array<int, maxOperators>& operatorRouting, int outputRouting, int numOperators);
+    
+    // the schedule with the given operators never evaluated, their outputs are left to the caller
+    Schedule withoutOperators(const Schedule& schedule, juce::uint32 operators);
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    SineEngine.h
+    Created: 18 Oct 2026 1:40:22pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Phase.h"
+
+// Sine backends for the operator oscillators. Each one takes the fixed point
+// phase bits for every lane of a SIMD register, see Phase.h. Errors are max
+// absolute error against double precision std::sin over one cycle, measured by
+// Benchmark::run(). Heavily modulated operators (around +-10 cycles) lose up to
+// 6e-6 converting the float modulation to phase, whichever backend is used.
+namespace Sine
+{
+    enum class Mode { exact, table, polynomial };
+
+    inline const juce::StringArray modeNames { "Exact", "Table", "Polynomial" };
+
+    // std::sin per lane, the reference. Max error 3.0e-8.
+    struct Exact
+    {
+        template <typename Vec>
+        static Vec process(Phase::Bits<Vec> phase)
+        {
+            constexpr double scale = juce::MathConstants<double>::twoPi / Phase::cycle;
+
+            Vec result;
+            for (size_t lane = 0; lane < Vec::size(); lane++)
+                result.set(lane, (float) std::sin((juce::int32) phase.get(lane) * scale));
+            return result;
+        }
+    };
+
+    // One cycle in 2048 points, linear interpolation. The top 11 phase bits are the
+    // index and the rest the fraction. Max error 1.2e-6.
+    struct Table
+    {
+        static constexpr int bits = 11;
+        static constexpr int size = 1 << bits;
+
+        // built on first use, call from prepareToPlay so it never happens on the audio thread
+        static const std::array<float, size + 1>& getTable()
+        {
+            static const auto table = []
+            {
+                std::array<float, size + 1> t;
+                for (int i = 0; i <= size; i++)
+                    t[i] = (float) std::sin(juce::MathConstants<double>::twoPi * i / size);
+                return t;
+            }();
+            return table;
+        }
+
+        template <typename Vec>
+        static Vec process(Phase::Bits<Vec> phase)
+        {
+            constexpr int fractionBits = 32 - bits;
+            constexpr float fractionScale = 1.0f / (1 << fractionBits);
+            const auto& table = getTable();
+
+            Vec a, b, fraction;
+            for (size_t lane = 0; lane < Vec::size(); lane++)
+            {
+                juce::uint32 p = phase.get(lane);
+                auto i = p >> fractionBits;
+                a.set(lane, table[i]);
+                b.set(lane, table[i + 1]);
+                fraction.set(lane, (float) (p & ((1u << fractionBits) - 1)) * fractionScale);
+            }
+            return a + fraction * (b - a);
+        }
+    };
+
+    // Odd degree 7 minimax polynomial of sin(2 pi z) for |z| <= 1/4 after folding
+    // the phase into that quarter cycle. Max error 7.4e-7, fully vectorized.
+    struct Polynomial
+    {
+        template <typename Vec>
+        static Vec process(Phase::Bits<Vec> phase)
+        {
+            auto z = Phase::toSignedCycles<Vec>(phase); // [-0.5, 0.5)
+
+            // sin(pi - x) = sin(x) folds into [-0.25, 0.25]
+            const auto half = Vec::expand(0.5f);
+            z += ((half - z * 2.0f) & Vec::greaterThan(z, Vec::expand(0.25f)));
+            z += ((Vec::expand(0.0f) - half - z * 2.0f) & Vec::lessThan(z, Vec::expand(-0.25f)));
+
+            auto z2 = z * z;
+            auto p = Vec::multiplyAdd(Vec::expand(81.34139840580086f), z2, Vec::expand(-71.00015800054501f));
+            p = Vec::multiplyAdd(Vec::expand(-41.33715873492265f), z2, p);
+            p = Vec::multiplyAdd(Vec::expand(6.283164146325853f), z2, p);
+            return z * p;
+        }
+    };
+}
@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+
+    Tuning.cpp
+    Created: 19 Oct 2026 1:47:32am
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "Tuning.h"
+
+namespace
+{
+    const juce::String equalTemperamentName { "12-TET" };
+    constexpr double middleCFrequency = 261.6255653005986; // equal tempered from A = 440 Hz
+
+    // Scala comments start with '!', every other line keeps its place
+    juce::StringArray withoutComments(const juce::String& text)
+    {
+        juce::StringArray lines;
+        for (const auto& line : juce::StringArray::fromLines(text))
+            if (! line.trimStart().startsWithChar('!'))
+                lines.add(line.trim());
+        return lines;
+    }
+
+    juce::String firstToken(const juce::String& line)
+    {
+        return line.upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false);
+    }
+
+    // a pitch with a period is in cents, anything else is a ratio or a whole number
+    bool parsePitch(const juce::String& line, double& cents)
+    {
+        auto token = firstToken(line);
+        if (token.isEmpty() || ! token.containsOnly("0123456789.-/"))
+            return false;
+
+        if (token.containsChar('.'))
+        {
+            cents = token.getDoubleValue();
+            return true;
+        }
+
+        auto numerator = token.upToFirstOccurrenceOf("/", false, false).getLargeIntValue();
+        auto denominator = token.containsChar('/') ? token.fromFirstOccurrenceOf("/", false, false).getLargeIntValue() : 1;
+        if (numerator <= 0 || denominator <= 0)
+            return false;
+
+        cents = 1200.0 * std::log2((double) numerator / (double) denominator);
+        return true;
+    }
+
+    int floorDivide(int a, int b)
+    {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0) ? 1 : 0);
+    }
+}
+
+Tuning::Table Tuning::equalTemperament()
+{
+    Table table;
+    for (int note = 0; note < numNotes; note++)
+    {
+        table.frequency[(size_t) note] = 440.0f * std::exp2((note - 69.0f) / 12.0f);
+        table.pitch[(size_t) note] = (float) note;
+    }
+    return table;
+}
+
+juce::Result Tuning::fromScala(const juce::String& scale, const juce::String& keyboardMapping, Table& table)
+{
+    // the first line is the description and may be empty, the second the number of degrees
+    auto scaleLines = withoutComments(scale);
+    if (scaleLines.size() < 2)
+        return juce::Result::fail("The scale has no note count");
+
+    const int numDegrees = scaleLines[1].getIntValue();
+    if (numDegrees < 1)
+        return juce::Result::fail("The scale has no notes");
+
+    std::vector<double> cents { 0.0 }; // the tonic isn't listed, the last degree is the period
+    for (int i = 2; i < scaleLines.size() && (int) cents.size() <= numDegrees; i++)
+    {
+        if (scaleLines[i].isEmpty())
+            continue;
+
+        double value;
+        if (! parsePitch(scaleLines[i], value))
+            return juce::Result::fail("Can't read the scale pitch \"" + scaleLines[i] + "\"");
+        cents.push_back(value);
+    }
+
+    if ((int) cents.size() != numDegrees + 1)
+        return juce::Result::fail("The scale has fewer notes than it says");
+
+    // without a mapping every key is the next degree, from middle C
+    int mapSize = 0, firstNote = 0, lastNote = numNotes - 1, middleNote = 60, referenceNote = 60;
+    double referenceFrequency = middleCFrequency;
+    int octaveDegree = numDegrees;
+    std::vector<int> mapping; // scale degree by key, -1 for keys left out
+
+    if (keyboardMapping.isNotEmpty())
+    {
+        juce::StringArray lines;
+        for (const auto& line : withoutComments(keyboardMapping))
+            if (line.isNotEmpty())
+                lines.add(line);
+
+        if (lines.size() < 7)
+            return juce::Result::fail("The keyboard mapping is incomplete");
+
+        mapSize = lines[0].getIntValue();
+        firstNote = juce::jlimit(0, numNotes - 1, lines[1].getIntValue());
+        lastNote = juce::jlimit(0, numNotes - 1, lines[2].getIntValue());
+        middleNote = lines[3].getIntValue();
+        referenceNote = lines[4].getIntValue();
+        referenceFrequency = firstToken(lines[5]).getDoubleValue();
+        octaveDegree = lines[6].getIntValue() > 0 ? lines[6].getIntValue() : numDegrees;
+
+        if (mapSize < 0 || lines.size() < 7 + mapSize)
+            return juce::Result::fail("The keyboard mapping has fewer keys than it says");
+        if (referenceFrequency <= 0.0)
+            return juce::Result::fail("The keyboard mapping has no reference frequency");
+
+        for (int i = 0; i < mapSize; i++)
+        {
+            auto token = firstToken(lines[7 + i]);
+            mapping.push_back(token.startsWithIgnoreCase("x") ? -1 : token.getIntValue());
+        }
+    }
+
+    const double period = cents[(size_t) numDegrees];
+    auto degreeCents = [&] (int degree)
+    {
+        int periods = floorDivide(degree, numDegrees);
+        return periods * period + cents[(size_t) (degree - periods * numDegrees)];
+    };
+
+    auto keyCents = [&] (int key, double& result)
+    {
+        int steps = key - middleNote;
+        if (mapSize == 0)
+        {
+            result = degreeCents(steps);
+            return true;
+        }
+
+        int repeats = floorDivide(steps, mapSize);
+        int degree = mapping[(size_t) (steps - repeats * mapSize)];
+        if (degree < 0)
+            return false;
+
+        result = repeats * degreeCents(octaveDegree) + degreeCents(degree);
+        return true;
+    };
+
+    double referenceCents;
+    if (! keyCents(referenceNote, referenceCents))
+        return juce::Result::fail("The reference note isn't mapped");
+
+    Table result;
+    for (int note = 0; note < numNotes; note++)
+    {
+        double noteCents;
+        double frequency = 0.0;
+        if (note >= firstNote && note <= lastNote && keyCents(note, noteCents))
+            frequency = referenceFrequency * std::exp2((noteCents - referenceCents) / 1200.0);
+
+        if (! std::isfinite(frequency))
+            return juce::Result::fail("The tuning goes out of range");
+
+        result.frequency[(size_t) note] = (float) frequency;
+        result.pitch[(size_t) note] = frequency > 0.0 ? (float) (69.0 + 12.0 * std::log2(frequency / 440.0)) : (float) note;
+    }
+
+    table = result;
+    return juce::Result::ok();
+}
+
+Tuning::Tuning() : name(equalTemperamentName)
+{
+}
+
+juce::Result Tuning::loadScala(const juce::String& scale, const juce::String& keyboardMapping)
+{
+    Table table;
+    auto result = fromScala(scale, keyboardMapping, table);
+    if (result.failed())
+        return result;
+
+    auto description = withoutComments(scale)[0];
+    {
+        const juce::ScopedLock sl(textLock);
+        name = description.isNotEmpty() ? description : "Scala";
+        scaleText = scale;
+        mappingText = keyboardMapping;
+    }
+    publish(table);
+    return result;
+}
+
+juce::Result Tuning::loadScala(const juce::File& scaleFile, const juce::File& keyboardMappingFile)
+{
+    if (! scaleFile.existsAsFile())
+        return juce::Result::fail("Can't open " + scaleFile.getFullPathName());
+
+    auto scale = scaleFile.loadFileAsString();
+    auto keyboardMapping = keyboardMappingFile.existsAsFile() ? keyboardMappingFile.loadFileAsString() : juce::String();
+    auto result = loadScala(scale, keyboardMapping);
+
+    if (result.wasOk() && withoutComments(scale)[0].isEmpty())
+    {
+        const juce::ScopedLock sl(textLock);
+        name = scaleFile.getFileNameWithoutExtension();
+    }
+    return result;
+}
+
+void Tuning::resetToEqualTemperament()
+{
+    {
+        const juce::ScopedLock sl(textLock);
+        name = equalTemperamentName;
+        scaleText = mappingText = {};
+    }
+    publish(equalTemperament());
+}
+
+juce::String Tuning::getName() const
+{
+    const juce::ScopedLock sl(textLock);
+    return name;
+}
+
+std::unique_ptr<juce::XmlElement> Tuning::createXml() const
+{
+    const juce::ScopedLock sl(textLock);
+    auto xml = std::make_unique<juce::XmlElement>(xmlTag);
+    xml->setAttribute("name", name);
+    xml->setAttribute("scale", scaleText);
+    xml->setAttribute("mapping", mappingText);
+    return xml;
+}
+
+// a tuning that no longer loads falls back to equal temperament rather than keep the last one
+void Tuning::restoreFromXml(const juce::XmlElement& xml)
+{
+    auto scale = xml.getStringAttribute("scale");
+    if (scale.isEmpty() || loadScala(scale, xml.getStringAttribute("mapping")).failed())
+    {
+        resetToEqualTemperament();
+        return;
+    }
+
+    const juce::ScopedLock sl(textLock);
+    name = xml.getStringAttribute("name", name);
+}
+
+// the audio thread only holds the staging table for as long as it takes to copy it
+void Tuning::publish(const Table& table)
+{
+    for (;;)
+    {
+        int expected = state.load();
+        if ((expected == idle || expected == ready) && state.compare_exchange_weak(expected, writing))
+            break;
+        juce::Thread::yield();
+    }
+
+    staging = table;
+    state.store(ready);
+}
+
+bool Tuning::takeTable(Table& table)
+{
+    int expected = ready;
+    if (! state.compare_exchange_strong(expected, reading))
+        return false;
+
+    table = staging;
+    state.store(idle);
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    Tuning.h
+    Created: 19 Oct 2026 1:47:32am
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Note frequencies for every MIDI note, worked out once when a tuning is loaded so a
+// note-on only looks its note up. Tunings come from Scala files: a scale (.scl) gives
+// the degrees of one period in cents or ratios, an optional keyboard mapping (.kbm)
+// gives which key plays which degree and the reference frequency. Without a mapping
+// the scale starts on middle C at its equal tempered frequency.
+//
+// Tables are built off the audio thread and handed to it through a single staging
+// table, the audio thread copies it out without ever waiting. The name and Scala text
+// are locked, hosts may restore state on another thread than the editor reads them on.
+class Tuning
+{
+public:
+    static constexpr int numNotes = 128;
+
+    struct Table
+    {
+        std::array<float, numNotes> frequency; // Hz, 0 for keys the mapping leaves out
+        std::array<float, numNotes> pitch; // in semitones on the MIDI note scale, what glides move through
+
+        bool isMapped(int note) const { return frequency[(size_t) note] > 0.0f; }
+    };
+
+    static Table equalTemperament();
+
+    // keyboardMapping may be empty. The table is only written when the result is ok,
+    // a failed tuning leaves it as it was
+    static juce::Result fromScala(const juce::String& scale, const juce::String& keyboardMapping, Table& table);
+
+    Tuning();
+
+    // any thread but the audio thread
+    juce::Result loadScala(const juce::String& scale, const juce::String& keyboardMapping);
+    juce::Result loadScala(const juce::File& scaleFile, const juce::File& keyboardMappingFile);
+    void resetToEqualTemperament();
+    juce::String getName() const;
+
+    // plugin state, the Scala text itself so a session doesn't depend on the files
+    std::unique_ptr<juce::XmlElement> createXml() const;
+    void restoreFromXml(const juce::XmlElement& xml);
+    static inline const juce::String xmlTag { "TUNING" };
+
+    // audio thread, copies a table published since the last call and returns true
+    bool takeTable(Table& table);
+
+private:
+    void publish(const Table& table);
+
+    enum State { idle, writing, ready, reading };
+    std::atomic<int> state { idle };
+    Table staging;
+
+    juce::CriticalSection textLock;
+    juce::String name, scaleText, mappingText;
+};
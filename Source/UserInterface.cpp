@@ -139,8 +139,8 @@ void OperatorInterface::timerCallback()
     float ratio = audioProcessor.apvts.getRawParameterValue("ratio" + juce::String(index))->load();
     float fixed = audioProcessor.apvts.getRawParameterValue("fixed" + juce::String(index))->load();
     float modIndex = audioProcessor.apvts.getRawParameterValue("amplitude" + juce::String(index))->load();
-    bool opMode = audioProcessor.apvts.getRawParameterValue("opMode" + juce::String(index))->load();
-    opGraphics.setRatioAndAmplitude(ratio, fixed, modIndex, opMode);
+    bool isRatio = audioProcessor.apvts.getRawParameterValue("opMode" + juce::String(index))->load() < 0.5f;
+    opGraphics.setRatioAndAmplitude(ratio, fixed, modIndex, isRatio);
     
     float attack = audioProcessor.apvts.getRawParameterValue("attack" + juce::String(index))->load();
     float decay = audioProcessor.apvts.getRawParameterValue("decay" + juce::String(index))->load();
@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+    VoiceAllocator.cpp
+    Created: 18 Oct 2026 8:47:10pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "VoiceAllocator.h"
+
+VoiceAllocator::VoiceAllocator()
+{
+    heapPosition.fill(-1);
+    activePosition.fill(-1);
+    noteVoice.fill(-1);
+    setNumVoices(maxVoices);
+}
+
+void VoiceAllocator::setNumVoices(int newNumVoices)
+{
+    numVoices = juce::jlimit(1, maxVoices, newNumVoices);
+
+    // lowest index on top so voices are handed out in order
+    numFree = 0;
+    for (int voice = numVoices - 1; voice >= 0; voice--)
+        if (activePosition[voice] < 0)
+            freeStack[numFree++] = voice;
+
+    rebuildHeap();
+}
+
+void VoiceAllocator::setStealPolicy(StealPolicy newPolicy)
+{
+    policy = newPolicy;
+    rebuildHeap();
+}
+
+int VoiceAllocator::startNote(int midiChannel, int midiNoteNumber)
+{
+    const int key = getKey(midiChannel, midiNoteNumber);
+    int voice = -1;
+
+    if (policy == StealPolicy::sameNote && noteVoice[key] >= 0 && heapPosition[noteVoice[key]] >= 0)
+        voice = noteVoice[key];
+    else if (numFree > 0)
+        voice = freeStack[--numFree];
+    else if (heapSize > 0)
+        voice = heap[0];
+    else
+        return -1;
+
+    auto& v = info[voice];
+    if (v.noteKey >= 0 && noteVoice[v.noteKey] == voice)
+        noteVoice[v.noteKey] = -1;
+
+    v.age = ++noteCounter;
+    v.loudness = 1.0f;
+    v.isReleased = false;
+    v.noteKey = key;
+    noteVoice[key] = voice;
+
+    if (activePosition[voice] < 0)
+    {
+        activePosition[voice] = numActive;
+        active[numActive++] = voice;
+    }
+
+    if (heapPosition[voice] < 0)
+    {
+        heapPush(voice);
+    }
+    else
+    {
+        // it was the most stealable voice and is now the newest
+        siftDown(heapPosition[voice]);
+        siftUp(heapPosition[voice]);
+    }
+
+    return voice;
+}
+
+void VoiceAllocator::releaseNote(int voice)
+{
+    info[voice].isReleased = true;
+
+    if (heapPosition[voice] >= 0)
+        siftUp(heapPosition[voice]);
+}
+
+void VoiceAllocator::changeNote(int voice, int midiChannel, int midiNoteNumber)
+{
+    auto& v = info[voice];
+    if (v.noteKey >= 0 && noteVoice[v.noteKey] == voice)
+        noteVoice[v.noteKey] = -1;
+
+    v.noteKey = getKey(midiChannel, midiNoteNumber);
+    noteVoice[v.noteKey] = voice;
+
+    // a tail that was picked up again is held like any other note
+    if (v.isReleased)
+    {
+        v.isReleased = false;
+        if (heapPosition[voice] >= 0)
+        {
+            siftDown(heapPosition[voice]);
+            siftUp(heapPosition[voice]);
+        }
+    }
+}
+
+void VoiceAllocator::finishVoice(int voice)
+{
+    if (activePosition[voice] < 0)
+        return;
+
+    if (heapPosition[voice] >= 0)
+        heapRemove(voice);
+
+    // swap the last active voice into this one's place
+    int position = activePosition[voice];
+    int last = active[--numActive];
+    active[position] = last;
+    activePosition[last] = position;
+    activePosition[voice] = -1;
+
+    auto& v = info[voice];
+    if (v.noteKey >= 0 && noteVoice[v.noteKey] == voice)
+        noteVoice[v.noteKey] = -1;
+    v.noteKey = -1;
+
+    if (voice < numVoices)
+        freeStack[numFree++] = voice;
+}
+
+void VoiceAllocator::setLoudness(int voice, float loudness)
+{
+    info[voice].loudness = loudness;
+
+    if (policy == StealPolicy::quietest && heapPosition[voice] >= 0)
+    {
+        siftDown(heapPosition[voice]);
+        siftUp(heapPosition[voice]);
+    }
+}
+
+int VoiceAllocator::findVoice(int midiChannel, int midiNoteNumber) const
+{
+    return noteVoice[getKey(midiChannel, midiNoteNumber)];
+}
+
+// true if voice a should be stolen before voice b
+bool VoiceAllocator::stealsBefore(int a, int b) const
+{
+    const auto& x = info[a];
+    const auto& y = info[b];
+
+    switch (policy)
+    {
+        case StealPolicy::quietest:
+            if (x.loudness != y.loudness)
+                return x.loudness < y.loudness;
+            break;
+
+        case StealPolicy::sameNote:
+        case StealPolicy::releaseFirst:
+            if (x.isReleased != y.isReleased)
+                return x.isReleased;
+            break;
+
+        case StealPolicy::oldest:
+            break;
+    }
+    return x.age < y.age;
+}
+
+void VoiceAllocator::heapPush(int voice)
+{
+    heap[heapSize] = voice;
+    heapPosition[voice] = heapSize;
+    siftUp(heapSize++);
+}
+
+void VoiceAllocator::heapRemove(int voice)
+{
+    int position = heapPosition[voice];
+    swapHeap(position, --heapSize);
+    heapPosition[voice] = -1;
+
+    if (position < heapSize)
+    {
+        siftDown(position);
+        siftUp(position);
+    }
+}
+
+void VoiceAllocator::siftUp(int position)
+{
+    while (position > 0)
+    {
+        int parent = (position - 1) / 2;
+        if (! stealsBefore(heap[position], heap[parent]))
+            break;
+
+        swapHeap(position, parent);
+        position = parent;
+    }
+}
+
+void VoiceAllocator::siftDown(int position)
+{
+    for (;;)
+    {
+        int first = position;
+        for (int child = 2 * position + 1; child <= 2 * position + 2 && child < heapSize; child++)
+            if (stealsBefore(heap[child], heap[first]))
+                first = child;
+
+        if (first == position)
+            break;
+
+        swapHeap(position, first);
+        position = first;
+    }
+}
+
+void VoiceAllocator::swapHeap(int a, int b)
+{
+    std::swap(heap[a], heap[b]);
+    heapPosition[heap[a]] = a;
+    heapPosition[heap[b]] = b;
+}
+
+// only voices under the limit can be stolen
+void VoiceAllocator::rebuildHeap()
+{
+    for (int i = 0; i < heapSize; i++)
+        heapPosition[heap[i]] = -1;
+
+    heapSize = 0;
+    for (int i = 0; i < numActive; i++)
+    {
+        int voice = active[i];
+        if (voice < numVoices)
+        {
+            heap[heapSize] = voice;
+            heapPosition[voice] = heapSize++;
+        }
+    }
+
+    for (int i = heapSize / 2 - 1; i >= 0; i--)
+        siftDown(i);
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    VoiceAllocator.h
+    Created: 18 Oct 2026 8:47:10pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Decides which voice of the pool plays a note. Free voices sit on a stack, the
+// sounding ones in a binary heap ordered by the steal policy, so starting a note
+// costs the same at 8 voices as at 128. Works on voice indices only.
+class VoiceAllocator
+{
+public:
+    static constexpr int maxVoices = 128;
+
+    enum class StealPolicy { oldest, quietest, sameNote, releaseFirst };
+    static inline const juce::StringArray stealPolicyNames { "Oldest", "Quietest", "Same Note", "Release First" };
+
+    VoiceAllocator();
+
+    // voices at or above the limit are never handed out again, the caller releases them
+    void setNumVoices(int numVoices);
+    int getNumVoices() const { return numVoices; }
+
+    void setStealPolicy(StealPolicy policy);
+    StealPolicy getStealPolicy() const { return policy; }
+
+    // the voice that should play the note, either a free one or one to steal
+    int startNote(int midiChannel, int midiNoteNumber);
+    void releaseNote(int voice);
+    void finishVoice(int voice);
+
+    // a sounding voice moved to another note without restarting, mono and legato
+    void changeNote(int voice, int midiChannel, int midiNoteNumber);
+
+    // only read by the quietest policy
+    void setLoudness(int voice, float loudness);
+
+    // the voice started last for this note, -1 if it has finished
+    int findVoice(int midiChannel, int midiNoteNumber) const;
+
+    // every voice that may still be sounding, including ones above the limit
+    int getNumActive() const { return numActive; }
+    int getActive(int i) const { return active[i]; }
+
+private:
+    bool stealsBefore(int a, int b) const;
+    void heapPush(int voice);
+    void heapRemove(int voice);
+    void siftUp(int position);
+    void siftDown(int position);
+    void swapHeap(int a, int b);
+    void rebuildHeap();
+
+    static int getKey(int midiChannel, int midiNoteNumber) { return ((midiChannel - 1) & 15) * 128 + (midiNoteNumber & 127); }
+
+    int numVoices = maxVoices;
+    StealPolicy policy = StealPolicy::releaseFirst;
+
+    std::array<int, maxVoices> freeStack;
+    int numFree = 0;
+
+    std::array<int, maxVoices> heap;
+    std::array<int, maxVoices> heapPosition; // -1 when not in the heap
+    int heapSize = 0;
+
+    std::array<int, maxVoices> active;
+    std::array<int, maxVoices> activePosition; // -1 when finished
+    int numActive = 0;
+
+    struct VoiceInfo
+    {
+        juce::uint64 age = 0;
+        float loudness = 0.0f;
+        bool isReleased = false;
+        int noteKey = -1;
+    };
+
+    std::array<VoiceInfo, maxVoices> info;
+    std::array<int, 16 * 128> noteVoice; // by channel and note
+    juce::uint64 noteCounter = 0;
+};
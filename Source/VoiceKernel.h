@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    VoiceKernel.h
+    Created: 18 Oct 2026 10:12:04am
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SineEngine.h"
+#include "Routing.h"
+
+// Structure-of-arrays render kernel: each SIMD lane holds one voice, so a
+// group of voices runs through the operator loop together. When there are fewer
+// voices than operators to fill the lanes, the operator-lane form below turns it
+// around and runs the operators of one voice side by side instead. Everything
+// is built for a fixed operator count, so the loops over operators unroll.
+namespace VoiceKernel
+{
+    template <typename Function, int... i>
+    inline void unrollSequence(Function& function, std::integer_sequence<int, i...>)
+    {
+        (function(std::integral_constant<int, i>()), ...);
+    }
+
+    // calls function(std::integral_constant<int, i>()) for i from 0 to N - 1, written out in full
+    template <int N, typename Function>
+    inline void unroll(Function&& function)
+    {
+        unrollSequence(function, std::make_integer_sequence<int, N>());
+    }
+
+    // phase and increment are fixed point (see Phase.h), modIndex is in cycles
+    template <typename Vec>
+    struct OperatorLanes
+    {
+        Phase::Bits<Vec> phase = Phase::Bits<Vec>::expand(0);
+        Phase::Bits<Vec> increment = Phase::Bits<Vec>::expand(0);
+        Phase::Bits<Vec> incrementStep = Phase::Bits<Vec>::expand(0);
+        Vec modIndex = Vec::expand(0.0f);
+        Vec modIndexStep = Vec::expand(0.0f);
+        Vec envelope = Vec::expand(0.0f);
+        Vec envelopeStep = Vec::expand(0.0f);
+        Vec output = Vec::expand(0.0f); // unit delay for algorithm
+    };
+
+    // a struct rather than an alias so the operator count can be deduced as an int
+    template <typename Vec, int NumOperators>
+    struct VoiceLanes : std::array<OperatorLanes<Vec>, (size_t) NumOperators> {};
+
+    // SineType is one of the Sine backends, picked once per block
+    template <typename SineType, typename Vec>
+    inline void processOperator(OperatorLanes<Vec>& op, Vec modulatorPhase)
+    {
+        op.increment += op.incrementStep;
+        op.modIndex += op.modIndexStep;
+        op.envelope += op.envelopeStep;
+        op.output = SineType::template process<Vec>(op.phase + Phase::wrapCycles(modulatorPhase * op.modIndex)) * op.envelope;
+
+        // wraps through overflow
+        op.phase += op.increment;
+    }
+
+    // an operator whose oscillator is the same in every voice and was rendered once for all
+    // of them, only the envelope is the voice's own
+    template <typename Vec>
+    inline void processSharedOperator(OperatorLanes<Vec>& op, float oscillator)
+    {
+        op.envelope += op.envelopeStep;
+        op.output = Vec::expand(oscillator) * op.envelope;
+    }
+
+    // stands in for numSamples calls of processOperator on a silent operator. The output
+    // is zero and the phase ends where it would have, so nothing changes but the cost.
+    // The increment is used up, the operator-lane form still steps every lane
+    template <typename Vec>
+    inline void skipOperator(OperatorLanes<Vec>& op, int numSamples)
+    {
+        const auto n = (juce::uint64) numSamples;
+        const auto stepSum = (juce::uint32) (n * (n + 1) / 2);
+        
+        for (size_t lane = 0; lane < Vec::size(); lane++)
+        {
+            juce::uint32 increment = op.increment.get(lane);
+            juce::uint32 step = op.incrementStep.get(lane);
+            op.phase.set(lane, op.phase.get(lane) + increment * (juce::uint32) n + step * stepSum);
+        }
+        
+        op.increment = Phase::Bits<Vec>::expand(0);
+        op.incrementStep = Phase::Bits<Vec>::expand(0);
+        op.output = Vec::expand(0.0f);
+    }
+
+    // only the operators in the schedule run, a source evaluated later in the
+    // schedule still holds last sample's output which makes it a unit delay.
+    // The schedule must have been compiled for NumOperators
+    template <typename SineType, int NumOperators, typename Vec>
+    inline Vec processSample(VoiceLanes<Vec, NumOperators>& op, const Routing::Schedule& schedule)
+    {
+        unroll<NumOperators>([&] (auto s)
+        {
+            if (s >= schedule.numSteps)
+                return;
+            
+            const auto& step = schedule.steps[s];
+            auto modulatorPhase = Vec::expand(0.0f);
+            unroll<NumOperators>([&] (auto k)
+            {
+                if (k < step.numSources)
+                    modulatorPhase += op[(size_t) step.sources[k]].output;
+            });
+
+            processOperator<SineType>(op[(size_t) step.op], modulatorPhase);
+        });
+
+        auto mix = Vec::expand(0.0f);
+        unroll<NumOperators>([&] (auto k)
+        {
+            if (k < schedule.numCarriers)
+                mix += op[(size_t) schedule.carriers[k]].output;
+        });
+
+        return mix;
+    }
+
+    // Which lanes each level of the schedule commits and where every operator
+    // reads its sources from, with operator i in lane i
+    template <typename Vec, int NumOperators>
+    struct OperatorLaneSchedule
+    {
+        using Mask = typename Vec::vMaskType;
+        static_assert(NumOperators <= (int) Vec::SIMDNumElements, "one lane per operator");
+
+        std::array<Mask, NumOperators> levels, otherLevels;
+        std::array<Mask, NumOperators> current, delayed; // by source, set in the lanes it modulates
+        Mask carriers;
+        int numLevels = 0;
+    };
+
+    template <typename Vec, int NumOperators>
+    OperatorLaneSchedule<Vec, NumOperators> makeOperatorLaneSchedule(const Routing::Schedule& schedule)
+    {
+        using Mask = typename Vec::vMaskType;
+        const auto on = std::numeric_limits<typename Mask::ElementType>::max();
+
+        OperatorLaneSchedule<Vec, NumOperators> laneSchedule;
+        laneSchedule.numLevels = schedule.numLevels;
+        laneSchedule.carriers = Mask::expand(0);
+
+        for (int i = 0; i < NumOperators; i++)
+        {
+            laneSchedule.levels[i] = Mask::expand(0);
+            laneSchedule.otherLevels[i] = Mask::expand(on);
+            laneSchedule.current[i] = Mask::expand(0);
+            laneSchedule.delayed[i] = Mask::expand(0);
+
+            for (int op = 0; op < NumOperators; op++)
+            {
+                if ((schedule.levels[i] >> op) & 1)
+                {
+                    laneSchedule.levels[i].set((size_t) op, on);
+                    laneSchedule.otherLevels[i].set((size_t) op, 0);
+                }
+            }
+        }
+
+        for (int s = 0; s < schedule.numSteps; s++)
+        {
+            const auto& step = schedule.steps[s];
+            for (int k = 0; k < step.numSources; k++)
+            {
+                auto& mask = step.isDelayed[k] ? laneSchedule.delayed : laneSchedule.current;
+                mask[step.sources[k]].set((size_t) step.op, on);
+            }
+        }
+
+        for (int k = 0; k < schedule.numCarriers; k++)
+            laneSchedule.carriers.set((size_t) schedule.carriers[k], on);
+
+        return laneSchedule;
+    }
+
+    // one voice of a group in operator-lane form and back
+    template <typename Vec, int NumOperators>
+    OperatorLanes<Vec> gatherVoice(const VoiceLanes<Vec, NumOperators>& lanes, size_t voice)
+    {
+        OperatorLanes<Vec> ops;
+        for (size_t i = 0; i < (size_t) NumOperators; i++)
+        {
+            ops.phase.set(i, lanes[i].phase.get(voice));
+            ops.increment.set(i, lanes[i].increment.get(voice));
+            ops.incrementStep.set(i, lanes[i].incrementStep.get(voice));
+            ops.modIndex.set(i, lanes[i].modIndex.get(voice));
+            ops.modIndexStep.set(i, lanes[i].modIndexStep.get(voice));
+            ops.envelope.set(i, lanes[i].envelope.get(voice));
+            ops.envelopeStep.set(i, lanes[i].envelopeStep.get(voice));
+            ops.output.set(i, lanes[i].output.get(voice));
+        }
+        return ops;
+    }
+
+    template <typename Vec, int NumOperators>
+    void scatterVoice(const OperatorLanes<Vec>& ops, VoiceLanes<Vec, NumOperators>& lanes, size_t voice)
+    {
+        for (size_t i = 0; i < (size_t) NumOperators; i++)
+        {
+            lanes[i].phase.set(voice, ops.phase.get(i));
+            lanes[i].output.set(voice, ops.output.get(i));
+        }
+    }
+
+    // same arithmetic per operator as processSample, one sine call per level instead of per operator.
+    // Lanes outside the level being evaluated keep their output, inactive operators are in no level
+    template <typename SineType, typename Vec, int NumOperators>
+    inline float processOperatorLanes(OperatorLanes<Vec>& op, const OperatorLaneSchedule<Vec, NumOperators>& schedule)
+    {
+        op.increment += op.incrementStep;
+        op.modIndex += op.modIndexStep;
+        op.envelope += op.envelopeStep;
+
+        const auto previous = op.output;
+
+        for (int level = 0; level < schedule.numLevels; level++)
+        {
+            // each source either feeds a lane from this sample or the last, never both
+            auto modulatorPhase = Vec::expand(0.0f);
+            for (size_t j = 0; j < (size_t) NumOperators; j++)
+                modulatorPhase += (Vec::expand(op.output.get(j)) & schedule.current[j])
+                                + (Vec::expand(previous.get(j)) & schedule.delayed[j]);
+
+            auto output = SineType::template process<Vec>(op.phase + Phase::wrapCycles(modulatorPhase * op.modIndex)) * op.envelope;
+            op.output = (output & schedule.levels[(size_t) level]) + (op.output & schedule.otherLevels[(size_t) level]);
+        }
+
+        op.phase += op.increment;
+
+        return (op.output & schedule.carriers).sum();
+    }
+}
@@ -11,4 +11,678 @@
 #include "VoiceProcessor.h"
 #include <JuceHeader.h>
 
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
 
+
+namespace
+{
+    void addToOutput(float* output, const float* mix, int numSamples)
+    {
+        juce::FloatVectorOperations::add(output, mix, numSamples);
+    }
+    
+    // the kernel stays in single precision for double hosts too, its lanes hold four floats
+    // and the sines are only good to about 1e-6. The finished mix is widened as it is added
+    void addToOutput(double* output, const float* mix, int numSamples)
+    {
+        int i = 0;
+       #if JUCE_USE_SSE_INTRINSICS
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            __m128 m = _mm_loadu_ps(mix + i);
+            _mm_storeu_pd(output + i, _mm_add_pd(_mm_loadu_pd(output + i), _mm_cvtps_pd(m)));
+            _mm_storeu_pd(output + i + 2, _mm_add_pd(_mm_loadu_pd(output + i + 2), _mm_cvtps_pd(_mm_movehl_ps(m, m))));
+        }
+       #elif JUCE_USE_ARM_NEON && defined (__aarch64__)
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            float32x4_t m = vld1q_f32(mix + i);
+            vst1q_f64(output + i, vaddq_f64(vld1q_f64(output + i), vcvt_f64_f32(vget_low_f32(m))));
+            vst1q_f64(output + i + 2, vaddq_f64(vld1q_f64(output + i + 2), vcvt_high_f64_f32(m)));
+        }
+       #endif
+        for (; i < numSamples; i++)
+            output[i] += mix[i];
+    }
+}
+
+void VoiceGroup::prepareToPlay(int samplesPerBlock)
+{
+    mix.assign((size_t) (samplesPerBlock << Oversampler::maxStages), 0.0f);
+}
+
+void VoiceGroup::render(int numSamples, const RenderContext& context)
+{
+    switch (context.sineMode)
+    {
+        case Sine::Mode::table:
+            renderSine<Sine::Table>(numSamples, context);
+            break;
+        case Sine::Mode::polynomial:
+            renderSine<Sine::Polynomial>(numSamples, context);
+            break;
+        default:
+            renderSine<Sine::Exact>(numSamples, context);
+            break;
+    }
+}
+
+template <typename SineType>
+void VoiceGroup::renderSine(int numSamples, const RenderContext& context)
+{
+    switch (context.schedule.numOperators)
+    {
+        case 8:
+            renderWith<SineType, 8>(numSamples, context);
+            break;
+        case 6:
+            renderWith<SineType, 6>(numSamples, context);
+            break;
+        default:
+            jassert(context.schedule.numOperators == 4);
+            renderWith<SineType, 4>(numSamples, context);
+            break;
+    }
+}
+
+template <typename SineType, int NumOperators>
+void VoiceGroup::renderWith(int numSamples, const RenderContext& context)
+{
+    const int oversampling = 1 << stage;
+    const int numSubSamples = numSamples * oversampling;
+    jassert(numSubSamples <= (int) mix.size());
+    
+    VoiceKernel::VoiceLanes<Lanes, NumOperators> lanes;
+    juce::uint32 silentOperators = (1u << NumOperators) - 1;
+    for (int lane = 0; lane < numVoices; lane++)
+    {
+        voices[lane]->loadLane(lanes, lane);
+        voices[lane]->renderControls(lanes, lane, numSamples, oversampling, context);
+        silentOperators &= voices[lane]->getSilentOperators();
+    }
+    
+    // operators silent in every voice of the group are left out, typically finished pluck modulators
+    silentOperators &= context.schedule.activeOperators;
+    for (int i = 0; i < NumOperators; i++)
+        if ((silentOperators >> i) & 1)
+            VoiceKernel::skipOperator(lanes[i], numSubSamples);
+    
+    // shared oscillators are read from the context instead of being evaluated
+    const juce::uint32 sharedOperators = context.sharedOperators & ~silentOperators;
+    const juce::uint32 leftOut = silentOperators | sharedOperators;
+    const auto schedule = leftOut != 0 ? Routing::withoutOperators(context.schedule, leftOut) : context.schedule;
+    
+    auto output = Lanes::expand(0.0f);
+    
+    // a few voices of a routing with few levels fill the lanes better one operator per lane,
+    // as long as the operators of a voice fit in one register and none are shared
+    bool isOperatorLaneForm = false;
+    if constexpr (NumOperators <= maxVoices)
+    {
+        if (numVoices * schedule.numLevels < schedule.numSteps && sharedOperators == 0)
+        {
+            isOperatorLaneForm = true;
+            const auto laneSchedule = VoiceKernel::makeOperatorLaneSchedule<Lanes, NumOperators>(schedule);
+            std::array<VoiceKernel::OperatorLanes<Lanes>, maxVoices> voiceOps;
+            for (int lane = 0; lane < numVoices; lane++)
+                voiceOps[lane] = VoiceKernel::gatherVoice(lanes, (size_t) lane);
+            
+            for (int sample = 0; sample < numSubSamples; ++sample)
+            {
+                float sum = 0.0f;
+                for (int lane = 0; lane < numVoices; lane++)
+                {
+                    float voiceOutput = VoiceKernel::processOperatorLanes<SineType>(voiceOps[lane], laneSchedule);
+                    output.set((size_t) lane, voiceOutput);
+                    sum += voiceOutput;
+                }
+                mix[(size_t) sample] = sum;
+            }
+            
+            for (int lane = 0; lane < numVoices; lane++)
+                VoiceKernel::scatterVoice(voiceOps[lane], lanes, (size_t) lane);
+        }
+    }
+    
+    if (! isOperatorLaneForm)
+    {
+        // every control is a linear ramp across the render, so there is nothing to do between samples
+        for (int sample = 0; sample < numSubSamples; ++sample)
+        {
+            // sources are always scheduled before what they modulate, so these come first
+            VoiceKernel::unroll<NumOperators>([&] (auto i)
+            {
+                if ((sharedOperators >> i) & 1)
+                    VoiceKernel::processSharedOperator(lanes[i], context.sharedOscillators[i][(size_t) stage][(size_t) sample]);
+            });
+            
+            output = VoiceKernel::processSample<SineType>(lanes, schedule);
+            mix[(size_t) sample] = output.sum();
+        }
+    }
+    
+    for (int lane = 0; lane < numVoices; lane++)
+    {
+        voices[lane]->storeLane(lanes, lane, output.get(lane));
+        voices[lane]->releaseIfSilent(context.schedule);
+    }
+}
+
+void FledgeSynthesiser::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    setCurrentPlaybackSampleRate(sampleRate);
+    controlInterval = juce::jmax(1, juce::roundToInt(sampleRate * controlPeriod));
+    samplesUntilControl = 0;
+    context.envelope = makeEnvelopeShape();
+    
+    // renders never cross a control tick, so nothing longer than a control period is buffered
+    maxBlockSamples = juce::jmin(samplesPerBlock, controlInterval);
+    oversampler.prepare(maxBlockSamples);
+    oversampler.reset();
+    
+    // rounded up to whole registers, the oscillators are rendered a register at a time
+    for (int i = 0; i < Routing::maxOperators; i++)
+    {
+        for (int stage = 0; stage <= Oversampler::maxStages; stage++)
+        {
+            sharedOscillators[i][stage].assign((size_t) ((maxBlockSamples << stage) + VoiceGroup::maxVoices), 0.0f);
+            context.sharedOscillators[i][stage] = sharedOscillators[i][stage].data();
+        }
+    }
+    sharedPhases.fill(0);
+    context.expression = &expression;
+    for (int i = 0; i < voices.size(); i++)
+    {
+        auto* voice = static_cast<SynthVoice*>(voices[i]);
+        voice->setIndex(i);
+        voice->setTuning(patch.tuning);
+    }
+    
+    for (auto& group : groups)
+        group.prepareToPlay(maxBlockSamples);
+    smoother.prepareToPlay(sampleRate, patch);
+}
+
+void FledgeSynthesiser::setPatch(const Patch& newPatch)
+{
+    bool routingChanged = newPatch.operatorRouting != patch.operatorRouting || newPatch.outputRouting != patch.outputRouting
+                       || newPatch.numOperators != patch.numOperators;
+    
+    // the filters hold the previous rate's signal
+    if (newPatch.oversamplingStages != patch.oversamplingStages || newPatch.isOversamplingAdaptive != patch.isOversamplingAdaptive)
+        oversampler.reset();
+    
+    patch = newPatch;
+    smoother.setTargets(patch);
+    context.envelope = makeEnvelopeShape();
+    context.sineMode = patch.sineMode;
+    context.glide = patch.glide;
+    expression.setSettings(patch.expression);
+    
+    if (routingChanged)
+        context.schedule = Routing::compile(patch.operatorRouting, patch.outputRouting, patch.numOperators);
+    
+    context.sharedOperators = 0;
+    for (int s = 0; s < context.schedule.numSteps; s++)
+    {
+        const auto& step = context.schedule.steps[s];
+        if (patch.op[step.op].isFixed && step.numSources == 0)
+            context.sharedOperators |= 1u << step.op;
+    }
+}
+
+Envelope::Shape FledgeSynthesiser::makeEnvelopeShape() const
+{
+    std::array<Envelope::Parameters, Envelope::maxOperators> envelopes;
+    for (int i = 0; i < Envelope::maxOperators; i++)
+        envelopes[i] = patch.op[i].envelope;
+    
+    return Envelope::makeShape(envelopes, patch.numOperators, getSampleRate(), controlInterval);
+}
+
+void FledgeSynthesiser::setPolyphony(int numVoices)
+{
+    const juce::ScopedLock sl(lock);
+    polyphony = numVoices;
+    
+    if (voiceMode == VoiceMode::poly)
+        setAllocatorLimit(polyphony);
+}
+
+void FledgeSynthesiser::setStealPolicy(VoiceAllocator::StealPolicy policy)
+{
+    const juce::ScopedLock sl(lock);
+    allocator.setStealPolicy(policy);
+}
+
+void FledgeSynthesiser::setVoiceMode(VoiceMode mode)
+{
+    const juce::ScopedLock sl(lock);
+    if (mode == voiceMode)
+        return;
+    
+    voiceMode = mode;
+    numHeldNotes = 0;
+    allNotesOff(0, true);
+    setAllocatorLimit(voiceMode == VoiceMode::poly ? polyphony : 1);
+}
+
+// voices above the new limit keep their tails but take no new notes
+void FledgeSynthesiser::setAllocatorLimit(int numVoices)
+{
+    allocator.setNumVoices(numVoices);
+    
+    for (int i = 0; i < allocator.getNumActive(); i++)
+    {
+        int index = allocator.getActive(i);
+        if (index >= allocator.getNumVoices() && voices[index]->isKeyDown())
+        {
+            voices[index]->setKeyDown(false);
+            stopVoice(voices[index], 0.0f, true);
+        }
+    }
+}
+
+void FledgeSynthesiser::noteOn(int midiChannel, int midiNoteNumber, float velocity)
+{
+    const juce::ScopedLock sl(lock);
+    
+    // keys the tuning leaves out don't play
+    if (! patch.tuning.isMapped(midiNoteNumber))
+        return;
+    
+    for (auto* sound : sounds)
+    {
+        if (! sound->appliesToNote(midiNoteNumber) || ! sound->appliesToChannel(midiChannel))
+            continue;
+        
+        if (voiceMode != VoiceMode::poly)
+        {
+            monoNoteOn(sound, midiChannel, midiNoteNumber, velocity);
+            continue;
+        }
+        
+        // a note that is still ringing is released first, same note stealing picks it up again instead
+        int ringing = allocator.findVoice(midiChannel, midiNoteNumber);
+        bool isRinging = ringing >= 0 && voices[ringing]->getCurrentlyPlayingNote() == midiNoteNumber
+                      && voices[ringing]->isPlayingChannel(midiChannel);
+        
+        if (isRinging && allocator.getStealPolicy() != VoiceAllocator::StealPolicy::sameNote)
+            releaseVoice(ringing, 1.0f, true);
+        
+        // looked at before the new note counts as held, and only when legato glide needs it
+        bool isLegatoGlide = patch.glide.isOn() && patch.glide.mode == Glide::Mode::legato;
+        float glideStart = getGlideStart(isLegatoGlide && isAnyKeyDown());
+        
+        int index = allocator.startNote(midiChannel, midiNoteNumber);
+        if (index < 0)
+            continue;
+        
+        auto* voice = static_cast<SynthVoice*>(voices[index]);
+        expression.startVoice(index, midiChannel);
+        if (isRinging && index == ringing)
+        {
+            voice->changeNote(midiNoteNumber, true, false);
+            voice->setKeyDown(true);
+        }
+        else
+        {
+            voice->setGlideStart(glideStart);
+            startVoice(voice, sound, midiChannel, midiNoteNumber, velocity);
+        }
+        lastPitch = patch.tuning.pitch[(size_t) midiNoteNumber];
+    }
+}
+
+void FledgeSynthesiser::noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    const juce::ScopedLock sl(lock);
+    
+    if (voiceMode != VoiceMode::poly)
+    {
+        monoNoteOff(midiNoteNumber, velocity, allowTailOff);
+        return;
+    }
+    
+    int index = allocator.findVoice(midiChannel, midiNoteNumber);
+    if (index < 0)
+        return;
+    
+    auto* voice = voices[index];
+    if (voice->isKeyDown() && voice->getCurrentlyPlayingNote() == midiNoteNumber && voice->isPlayingChannel(midiChannel))
+        releaseVoice(index, velocity, allowTailOff);
+}
+
+void FledgeSynthesiser::handleSustainPedal(int midiChannel, bool isDown)
+{
+    const juce::ScopedLock sl(lock);
+    juce::Synthesiser::handleSustainPedal(midiChannel, isDown);
+    
+    // voices held only by the pedal were just stopped
+    if (! isDown)
+        for (int i = 0; i < allocator.getNumActive(); i++)
+            if (! voices[allocator.getActive(i)]->isKeyDown())
+                allocator.releaseNote(allocator.getActive(i));
+}
+
+// one wheel for all channels, the voices pick it up at the next control period
+void FledgeSynthesiser::handlePitchWheel(int midiChannel, int wheelValue)
+{
+    juce::Synthesiser::handlePitchWheel(midiChannel, wheelValue);
+    
+    float bend = juce::jlimit(-1.0f, 1.0f, (float) (wheelValue - 8192) / 8191.0f);
+    if (expression.isPerNote(midiChannel))
+        expression.setChannelBend(midiChannel, bend);
+    else
+        smoother.setPitchBend(bend);
+}
+
+void FledgeSynthesiser::handleController(int midiChannel, int controllerNumber, int controllerValue)
+{
+    juce::Synthesiser::handleController(midiChannel, controllerNumber, controllerValue);
+    
+    if (controllerNumber == modWheelController)
+        smoother.setModWheel((float) controllerValue / 127.0f);
+    else if (controllerNumber == slideController && expression.isPerNote(midiChannel))
+        expression.setChannelSlide(midiChannel, (float) controllerValue / 127.0f);
+}
+
+void FledgeSynthesiser::handleChannelPressure(int midiChannel, int channelPressureValue)
+{
+    juce::Synthesiser::handleChannelPressure(midiChannel, channelPressureValue);
+    expression.setChannelPressure(midiChannel, (float) channelPressureValue / 127.0f);
+}
+
+void FledgeSynthesiser::handleAftertouch(int midiChannel, int midiNoteNumber, int aftertouchValue)
+{
+    juce::Synthesiser::handleAftertouch(midiChannel, midiNoteNumber, aftertouchValue);
+    
+    int index = allocator.findVoice(midiChannel, midiNoteNumber);
+    if (index >= 0 && voices[index]->isKeyDown())
+        expression.setNotePressure(index, (float) aftertouchValue / 127.0f);
+}
+
+void FledgeSynthesiser::releaseVoice(int index, float velocity, bool allowTailOff)
+{
+    auto* voice = voices[index];
+    voice->setKeyDown(false);
+    
+    if (voice->isSustainPedalDown() || voice->isSostenutoPedalDown())
+        return;
+    
+    stopVoice(voice, velocity, allowTailOff);
+    allocator.releaseNote(index);
+}
+
+// Mono and legato share voice 0. The last held note sounds, releasing it falls back
+// to the one held before. Legato only retriggers the envelopes when no key was down.
+void FledgeSynthesiser::monoNoteOn(juce::SynthesiserSound* sound, int midiChannel, int midiNoteNumber, float velocity)
+{
+    removeHeldNote(midiNoteNumber);
+    heldNotes[(size_t) numHeldNotes++] = { midiChannel, midiNoteNumber };
+    
+    auto* voice = static_cast<SynthVoice*>(voices[0]);
+    float glideStart = getGlideStart(voice->isKeyDown());
+    lastPitch = patch.tuning.pitch[(size_t) midiNoteNumber];
+    expression.startVoice(0, midiChannel);
+    
+    if (voice->isVoiceActive())
+    {
+        bool isLegato = voiceMode == VoiceMode::legato && voice->isKeyDown();
+        moveMonoVoice(sound, heldNotes[(size_t) numHeldNotes - 1], velocity, ! isLegato, glideStart >= 0.0f);
+        return;
+    }
+    
+    if (allocator.startNote(midiChannel, midiNoteNumber) == 0)
+    {
+        voice->setGlideStart(glideStart);
+        startVoice(voice, sound, midiChannel, midiNoteNumber, velocity);
+    }
+}
+
+void FledgeSynthesiser::monoNoteOff(int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    bool wasSounding = numHeldNotes > 0 && heldNotes[(size_t) numHeldNotes - 1].midiNoteNumber == midiNoteNumber;
+    removeHeldNote(midiNoteNumber);
+    
+    auto* voice = voices[0];
+    if (! wasSounding || ! voice->isKeyDown())
+        return;
+    
+    if (numHeldNotes > 0)
+    {
+        // falling back to a held note is always legato
+        const auto& held = heldNotes[(size_t) numHeldNotes - 1];
+        lastPitch = patch.tuning.pitch[(size_t) held.midiNoteNumber];
+        moveMonoVoice(voice->getCurrentlyPlayingSound().get(), held, velocity, voiceMode == VoiceMode::mono, patch.glide.isOn());
+    }
+    else
+        releaseVoice(0, velocity, allowTailOff);
+}
+
+void FledgeSynthesiser::removeHeldNote(int midiNoteNumber)
+{
+    for (int i = 0; i < numHeldNotes; i++)
+    {
+        if (heldNotes[(size_t) i].midiNoteNumber == midiNoteNumber)
+        {
+            std::copy(heldNotes.begin() + i + 1, heldNotes.begin() + numHeldNotes, heldNotes.begin() + i);
+            numHeldNotes--;
+            return;
+        }
+    }
+}
+
+// voice 0 carries on at the note, registered under it with the allocator and juce::Synthesiser
+// so note offs, aftertouch and the pedals find it there
+void FledgeSynthesiser::moveMonoVoice(juce::SynthesiserSound* sound, const HeldNote& note, float velocity, bool retrigger, bool shouldSlide)
+{
+    auto* voice = static_cast<SynthVoice*>(voices[0]);
+    allocator.changeNote(0, note.midiChannel, note.midiNoteNumber);
+    voice->prepareMove(retrigger, shouldSlide);
+    startVoice(voice, sound, note.midiChannel, note.midiNoteNumber, velocity);
+}
+
+// where a new note slides from, negative when it starts on its own pitch
+float FledgeSynthesiser::getGlideStart(bool isOverlapping) const
+{
+    if (! patch.glide.isOn() || lastPitch < 0.0f)
+        return -1.0f;
+    
+    if (patch.glide.mode == Glide::Mode::legato && ! isOverlapping)
+        return -1.0f;
+    
+    return lastPitch;
+}
+
+bool FledgeSynthesiser::isAnyKeyDown() const
+{
+    for (int i = 0; i < allocator.getNumActive(); i++)
+        if (voices[allocator.getActive(i)]->isKeyDown())
+            return true;
+    return false;
+}
+
+void FledgeSynthesiser::renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    renderVoicesInto(outputAudio, startSample, numSamples);
+}
+
+// the voices render in single precision whatever the host asks for, a double
+// buffer takes the finished mix straight from the base rate bus
+void FledgeSynthesiser::renderVoices(juce::AudioBuffer<double>& outputAudio, int startSample, int numSamples)
+{
+    renderVoicesInto(outputAudio, startSample, numSamples);
+}
+
+template <typename SampleType>
+void FledgeSynthesiser::renderVoicesInto(juce::AudioBuffer<SampleType>& outputAudio, int startSample, int numSamples)
+{
+    jassert(maxBlockSamples > 0);
+    
+    const int numStages = patch.oversamplingStages;
+    const bool isAdaptive = patch.isOversamplingAdaptive;
+    
+    // one control period at a time, a period cut by the end of the host block continues in the next one
+    while (numSamples > 0 && maxBlockSamples > 0)
+    {
+        if (samplesUntilControl == 0)
+            samplesUntilControl = controlInterval;
+        
+        int blockSamples = juce::jmin(numSamples, maxBlockSamples, samplesUntilControl);
+        samplesUntilControl -= blockSamples;
+        bool anyVoiceActive = false;
+        oversampler.clear(blockSamples, numStages);
+        smoother.advance(context.controls, context.pitchBend, patch, blockSamples);
+        expression.advance(allocator, blockSamples, getSampleRate());
+        
+        // voices are grouped by the rate they render at, each rate has its own bus
+        std::array<int, Oversampler::maxStages + 1> openGroup;
+        openGroup.fill(-1);
+        numGroups = 0;
+        juce::uint32 stagesInUse = 0;
+        
+        for (int i = 0; i < allocator.getNumActive(); i++)
+        {
+            auto* voice = voices[allocator.getActive(i)];
+            if (! voice->isVoiceActive())
+                continue;
+            
+            // every voice added to this synth is a SynthVoice
+            auto* synthVoice = static_cast<SynthVoice*>(voice);
+            int stage = isAdaptive ? synthVoice->chooseOversamplingStages(context, numStages) : numStages;
+            
+            if (openGroup[stage] < 0)
+            {
+                openGroup[stage] = numGroups++;
+                groups[openGroup[stage]].start(stage);
+                stagesInUse |= 1u << stage;
+            }
+            
+            auto& group = groups[openGroup[stage]];
+            group.add(*synthVoice);
+            anyVoiceActive = true;
+            
+            if (group.isFull())
+                openGroup[stage] = -1;
+        }
+        
+        if (context.sharedOperators != 0)
+            renderSharedOscillators(blockSamples, stagesInUse);
+        
+        // groups share nothing but the context, so they can render on any thread
+        renderSamples = blockSamples;
+        if (isMultithreaded && workerPool->getNumThreads() > 1)
+            workerPool->run(batch, &FledgeSynthesiser::renderGroup, this, numGroups);
+        else
+            for (int i = 0; i < numGroups; i++)
+                renderGroup(this, i, 0);
+        
+        // mixed in group order, the sum doesn't depend on which thread rendered what
+        for (int i = 0; i < numGroups; i++)
+        {
+            int stage = groups[i].getStage();
+            juce::FloatVectorOperations::add(oversampler.getBus(stage), groups[i].getMix(), blockSamples << stage);
+        }
+        
+        // hand finished voices back, backwards because finishing reorders the ones after it
+        bool isQuietestPolicy = allocator.getStealPolicy() == VoiceAllocator::StealPolicy::quietest;
+        for (int i = allocator.getNumActive() - 1; i >= 0; i--)
+        {
+            int index = allocator.getActive(i);
+            auto* voice = static_cast<SynthVoice*>(voices[index]);
+            
+            if (! voice->isVoiceActive())
+                allocator.finishVoice(index);
+            else if (isQuietestPolicy)
+                allocator.setLoudness(index, voice->getLoudness(context.schedule));
+        }
+        
+        // decimate once on the summed voices, keep running after the last voice so the filters drain
+        oversampler.decimate(blockSamples, numStages, isAdaptive);
+        
+        if (anyVoiceActive || numStages > 0)
+            for (int channel = 0; channel < outputAudio.getNumChannels(); ++channel)
+                addToOutput(outputAudio.getWritePointer(channel, startSample), oversampler.getBus(0), blockSamples);
+        
+        startSample += blockSamples;
+        numSamples -= blockSamples;
+    }
+}
+
+void FledgeSynthesiser::renderGroup(void* synth, int group, int thread)
+{
+    auto& self = *static_cast<FledgeSynthesiser*>(synth);
+    self.groups[group].render(self.renderSamples, self.context);
+}
+
+void FledgeSynthesiser::renderSharedOscillators(int numSamples, juce::uint32 stages)
+{
+    switch (context.sineMode)
+    {
+        case Sine::Mode::table:
+            renderSharedOscillatorsWith<Sine::Table>(numSamples, stages);
+            break;
+        case Sine::Mode::polynomial:
+            renderSharedOscillatorsWith<Sine::Polynomial>(numSamples, stages);
+            break;
+        default:
+            renderSharedOscillatorsWith<Sine::Exact>(numSamples, stages);
+            break;
+    }
+}
+
+// the same ramps SynthVoice::renderControls would give the operator. Every rate starts
+// from the same phase, so voices at different rates hear the same waveform
+template <typename SineType>
+void FledgeSynthesiser::renderSharedOscillatorsWith(int numSamples, juce::uint32 stages)
+{
+    using Lanes = VoiceGroup::Lanes;
+    const double sampleRate = getSampleRate();
+    
+    for (int i = 0; i < Routing::maxOperators; i++)
+    {
+        if (! ((context.sharedOperators >> i) & 1))
+            continue;
+        
+        const auto& fixed = context.controls[i].fixed;
+        
+        for (int stage = 0; stage <= Oversampler::maxStages; stage++)
+        {
+            if (! ((stages >> stage) & 1))
+                continue;
+            
+            const int numSubSamples = numSamples << stage;
+            const double rateScale = 1.0 / (sampleRate * (1 << stage));
+            juce::uint32 increment = Phase::fromCycles(fixed.start * rateScale);
+            const juce::uint32 step = Phase::stepFromCycles((fixed.end - fixed.start) * rateScale / numSubSamples);
+            juce::uint32 phase = sharedPhases[i];
+            float* oscillator = sharedOscillators[i][stage].data();
+            
+            for (int sample = 0; sample < numSubSamples; sample += (int) Lanes::size())
+            {
+                Phase::Bits<Lanes> phases;
+                for (size_t lane = 0; lane < Lanes::size(); lane++)
+                {
+                    increment += step;
+                    phases.set(lane, phase);
+                    phase += increment;
+                }
+                
+                auto output = SineType::template process<Lanes>(phases);
+                for (size_t lane = 0; lane < Lanes::size(); lane++)
+                    oscillator[(size_t) sample + lane] = output.get(lane);
+            }
+        }
+        
+        // where the base rate oscillator ends, in closed form as in VoiceKernel::skipOperator
+        const auto n = (juce::uint64) numSamples;
+        const juce::uint32 increment = Phase::fromCycles(fixed.start / sampleRate);
+        const juce::uint32 step = Phase::stepFromCycles((fixed.end - fixed.start) / sampleRate / numSamples);
+        sharedPhases[i] += increment * (juce::uint32) n + step * (juce::uint32) (n * (n + 1) / 2);
+    }
+}
@@ -11,6 +11,10 @@
 #pragma once
 #include <JuceHeader.h>
 #include "Operator.h"
+#include "VoiceKernel.h"
+#include "Oversampler.h"
+#include "VoiceAllocator.h"
+#include "WorkerPool.h"
 
 class SynthSound : public juce::SynthesiserSound
 {
@@ -19,16 +23,34 @@ public:
     bool appliesToChannel(int midiChannel) override { return 1; }
 };
 
+// Everything voices read while rendering a block, one per synth and shared by all voices.
+struct RenderContext
+{
+    Routing::Schedule schedule;
+    Envelope::Shape envelope;
+    PatchControls controls;
+    Ramp pitchBend { 1.0f, 1.0f }; // frequency ratio, the same for every voice
+    const NoteExpression* expression = nullptr; // each voice's own, by voice index
+    Sine::Mode sineMode = Sine::Mode::exact;
+    Glide::Settings glide;
+    
+    // Fixed frequency operators without modulators sound the same in every voice. Their
+    // oscillators run once per block at every rate in use, the voices only apply envelopes
+    juce::uint32 sharedOperators = 0;
+    std::array<std::array<const float*, Oversampler::maxStages + 1>, Routing::maxOperators> sharedOscillators {};
+};
+
 class SynthVoice : public juce::SynthesiserVoice
 {
 public:
     void prepareToPlay(double sampleRate, float samplesPerBlock, int numChannels)
     {
         this->sampleRate = sampleRate;
-        for (int i = 0; i < 4; i++)
+        for (int i = 0; i < maxOperators; i++)
         {
             op[i].prepareToPlay(sampleRate, samplesPerBlock, numChannels);
         }
+        reset();
     }
     
     bool canPlaySound (juce::SynthesiserSound* sound) override
@@ -38,124 +60,417 @@ public:
     
     void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound *sound, int currentPitchWheelPosition) override
     {
-        for (int i = 0; i < 4; i++)
+        if (isMoving)
         {
-            op[i].startNote();
-            op[i].setNoteNumber(midiNoteNumber);
+            isMoving = false;
+            changeNote(midiNoteNumber, moveRetriggers, moveSlides);
+            return;
         }
+        
+        isReleasing = false;
+        for (int i = 0; i < maxOperators; i++)
+            op[i].startNote();
+        
+        const float pitch = tuning->pitch[(size_t) midiNoteNumber];
+        glide.jumpTo(glideStart >= 0.0f ? glideStart : pitch);
+        glide.slideTo(pitch);
+        glideStart = -1.0f;
+        noteFrequency = glide.isSliding() ? Glide::toFrequency(glide.getPitch()) : tuning->frequency[(size_t) midiNoteNumber];
+        
+        // the envelope starts with the next control pass, which begins at this event
+        pendingNoteOn = true;
+        pendingNoteOff = false;
     }
     
-    void stopNote(float velocity, bool allowTailOff) override
+    // where the voice sits in the synth's pool, and so in the per-voice arrays
+    void setIndex(int newIndex) { index = newIndex; }
+    
+    // the synth's note table, notes are looked up in it as they start
+    void setTuning(const Tuning::Table& table) { tuning = &table; }
+    
+    // the pitch the next startNote slides from, a negative pitch starts on the note
+    void setGlideStart(float pitch) { glideStart = pitch; }
+    
+    // the synth's next startVoice for this voice becomes a changeNote. Going through
+    // startVoice keeps the note juce::Synthesiser reports for the voice up to date
+    void prepareMove(bool retrigger, bool shouldSlide)
+    {
+        isMoving = true;
+        moveRetriggers = retrigger;
+        moveSlides = shouldSlide;
+    }
+    
+    // mono and legato: carry on at a new pitch without restarting the phases
+    void changeNote(int midiNoteNumber, bool retrigger, bool shouldSlide)
     {
-        for (int i = 0; i < 4; i++)
+        // a slide carries on from the current pitch, only a jump lands on the note
+        const float pitch = tuning->pitch[(size_t) midiNoteNumber];
+        if (shouldSlide)
+            glide.slideTo(pitch);
+        else
+            glide.jumpTo(pitch);
+        
+        if (! glide.isSliding())
+            noteFrequency = tuning->frequency[(size_t) midiNoteNumber];
+        
+        isReleasing = false;
+        if (retrigger)
         {
-            op[i].stopNote();
+            pendingNoteOn = true;
+            pendingNoteOff = false;
         }
     }
     
-    void setEnvelope(int index, float attack, float decay, float sustain, float release, float globalAttack, float globalDecay, float globalSustain, float globalRelease)
+    void stopNote(float velocity, bool allowTailOff) override
     {
-        float attackScaled = std::pow(2.0f, globalAttack / 100.0f) * attack;
-        float decayScaled = std::pow(2.0f, globalDecay / 100.0f) * decay;
-        float sustainScaled = std::pow(2.0f, globalSustain / 100.0f) * sustain;
-        sustainScaled = juce::jlimit(0.0f, 1.0f, sustainScaled);
-        float releaseScaled = std::pow(2.0f, globalRelease / 100.0f) * release;
-
-        op[index].setEnvelope(attackScaled,
-                              decayScaled,
-                              sustainScaled,
-                              releaseScaled, false);
+        // startVoice stops the old note before a move, the voice carries on instead
+        if (isMoving)
+            return;
+        
+        if (! allowTailOff)
+        {
+            reset();
+            return;
+        }
+        
+        isReleasing = true;
+        pendingNoteOff = true;
     }
     
-    void setFMParameters(int index, float ratio, float fixed, bool isFixed, float modIndex)
+    // once released, a voice frees itself when none of its carriers can be heard anymore
+    void releaseIfSilent(const Routing::Schedule& schedule)
     {
-        op[index].setOperator(ratio, fixed, isFixed, modIndex);
+        if (! isReleasing)
+            return;
+        
+        for (int k = 0; k < schedule.numCarriers; k++)
+        {
+            int carrier = schedule.carriers[k];
+            if (envelope.isActive(carrier) && envelope.getLevel(carrier) >= silenceThreshold)
+                return;
+        }
+        reset();
     }
     
-    
+    // the wheels act on every voice at once, FledgeSynthesiser smooths them into the context
     void pitchWheelMoved(int newPitchWheelValue) override {}
     void controllerMoved(int controllerNumber, int newControllerValue) override {}
     void renderNextBlock(juce::AudioBuffer<float> &outputBuffer, int startSample, int numSamples) override
     {
-        for (int sample = 0; sample < outputBuffer.getNumSamples(); ++sample) {
-            op3 = op[3].processOperator(op0 * op3Gain[0],
-                                        op1 * op3Gain[1],
-                                        op2 * op3Gain[2],
-                                        op3 * op3Gain[3]);
+        // voices are rendered in lane groups, see FledgeSynthesiser::renderVoices
+    }
+    
+    // loudest carrier envelope, what the quietest steal policy compares
+    float getLoudness(const Routing::Schedule& schedule) const
+    {
+        float loudness = 0.0f;
+        for (int k = 0; k < schedule.numCarriers; k++)
+            loudness = juce::jmax(loudness, envelope.getLevel(schedule.carriers[k]));
+        return loudness;
+    }
+    
+    // Carson's rule in schedule order: an operator's spectrum reaches its own frequency
+    // plus (index + 1) times the highest frequency of its modulators. Delayed sources
+    // haven't been estimated yet and count with their own frequency. Returns the fewest
+    // stages that keep the highest sideband under the kernel's Nyquist frequency.
+    int chooseOversamplingStages(const RenderContext& context, int maxStages) const
+    {
+        const auto& schedule = context.schedule;
+        const auto& controls = context.controls;
+        std::array<float, maxOperators> highest {}; // cycles per base rate sample
+        
+        const auto& expression = *context.expression;
+        const auto v = (size_t) index;
+        
+        // a slide may end anywhere up to its note
+        float bend = juce::jmax(context.pitchBend.start, context.pitchBend.end) * juce::jmax(expression.bendRatioStart[v], expression.bendRatioEnd[v]);
+        Ramp noteRange { noteFrequency * bend, (glide.isSliding() ? Glide::toFrequency(glide.getTarget()) : noteFrequency) * bend };
+        
+        for (int s = 0; s < schedule.numSteps; s++)
+        {
+            const auto& step = schedule.steps[s];
+            auto increment = op[step.op].getPhaseIncrement(controls[step.op], noteRange);
+            float frequency = juce::jmax(increment.start, increment.end);
+            auto modIndexRamp = getModIndex(controls[step.op], expression);
+            float modIndex = juce::jmax(modIndexRamp.start, modIndexRamp.end);
             
-            op2 = op[2].processOperator(op0 * op2Gain[0],
-                                        op1 * op2Gain[1],
-                                        op2 * op2Gain[2],
-                                        op3 * op2Gain[3]);
-
-            op1 = op[1].processOperator(op0 * op1Gain[0],
-                                        op1 * op1Gain[1],
-                                        op2 * op1Gain[2],
-                                        op3 * op1Gain[3]);
-
-            op0 = op[0].processOperator(op0 * op0Gain[0],
-                                        op1 * op0Gain[1],
-                                        op2 * op0Gain[2],
-                                        op3 * op0Gain[3]);
-
-            float output = op0 * outputGain[0] +
-                           op1 * outputGain[1] +
-                           op2 * outputGain[2] +
-                        op3 * outputGain[3];
-
-            outputSample = output;
-            for (int channel = 0; channel < outputBuffer.getNumChannels(); ++channel) {
-                outputBuffer.addSample(channel, sample, output);
+            float deviation = 0.0f, widest = 0.0f;
+            for (int k = 0; k < step.numSources; k++)
+            {
+                int source = step.sources[k];
+                float sourceHighest = step.isDelayed[k] ? juce::jmax(highest[source], op[source].getPhaseIncrement(controls[source], noteRange).end) : highest[source];
+                deviation += modIndex * sourceHighest;
+                widest = juce::jmax(widest, sourceHighest);
             }
+            highest[step.op] = frequency + deviation + (deviation > 0.0f ? widest : 0.0f);
         }
+        
+        float bandwidth = 0.0f;
+        for (int k = 0; k < schedule.numCarriers; k++)
+            bandwidth = juce::jmax(bandwidth, highest[schedule.carriers[k]]);
+        
+        int stages = 0;
+        while (stages < maxStages && bandwidth > 0.5f * (1 << stages))
+            stages++;
+        return stages;
+    }
+    
+    float getOutputSample()
+    {
+        return outputSample;
     }
     
-    void setOperatorGain(int index, int gainIndex)
-    {
-        switch(index){
-            case 0:
-                outputGain = toBinary4(gainIndex);
-                break;
-            case 1:
-                op0Gain = toBinary4(gainIndex);
-                break;
-            case 2:
-                op1Gain = toBinary4(gainIndex);
-                break;
-            case 3:
-                op2Gain = toBinary4(gainIndex);
-                break;
-            case 4:
-                op3Gain = toBinary4(gainIndex);
-                break;
+    template <int NumOperators, typename Vec>
+    void loadLane(VoiceKernel::VoiceLanes<Vec, NumOperators>& lanes, size_t lane) const
+    {
+        for (int i = 0; i < NumOperators; i++)
+        {
+            lanes[i].phase.set(lane, op[i].getPhase());
+            lanes[i].envelope.set(lane, envelope.getLevel(i));
+            lanes[i].output.set(lane, operatorOutput[i]);
         }
     }
     
-    float getOutputSample()
+    // control rate pass over envelopes and the patch controls, everything becomes a ramp the
+    // kernel applies per sample. numSamples is at the base rate, the kernel runs oversampling times as many
+    template <int NumOperators, typename Vec>
+    void renderControls(VoiceKernel::VoiceLanes<Vec, NumOperators>& lanes, size_t lane, int numSamples, int oversampling, const RenderContext& context)
     {
-        return outputSample;
+        const auto& schedule = context.schedule;
+        const auto& controls = context.controls;
+        const auto& expression = *context.expression;
+        const auto v = (size_t) index;
+        const double rateScale = 1.0 / oversampling;
+        const double stepScale = 1.0 / (numSamples * oversampling);
+        const float modIndexScale = 1.0f / juce::MathConstants<float>::twoPi;
+        
+        if (pendingNoteOn)
+            envelope.noteOn(context.envelope);
+        if (pendingNoteOff)
+            envelope.noteOff(context.envelope);
+        pendingNoteOn = pendingNoteOff = false;
+        
+        silentOperators = 0;
+        for (int i = 0; i < NumOperators; i++)
+            if (envelope.isSilent(i))
+                silentOperators |= 1u << i;
+        
+        // every operator at once, inactive ones are written too but never read
+        std::array<float, NumOperators> startLevel;
+        for (int i = 0; i < NumOperators; i++)
+            startLevel[i] = envelope.getLevel(i);
+        
+        envelope.advance(context.envelope, numSamples);
+        
+        // the pitch only moves while sliding, otherwise the frequency ramp is flat but for the bend
+        const float startFrequency = noteFrequency;
+        if (glide.isSliding())
+        {
+            glide.advance(numSamples, context.glide, sampleRate);
+            noteFrequency = Glide::toFrequency(glide.getPitch());
+        }
+        Ramp frequency { startFrequency * context.pitchBend.start * expression.bendRatioStart[v],
+                         noteFrequency * context.pitchBend.end * expression.bendRatioEnd[v] };
+        
+        for (int i = 0; i < NumOperators; i++)
+            lanes[i].envelopeStep.set(lane, (envelope.getLevel(i) - startLevel[i]) * (float) stepScale);
+        
+        for (int s = 0; s < schedule.numSteps; s++)
+        {
+            int i = schedule.steps[s].op;
+            auto increment = op[i].getPhaseIncrement(controls[i], frequency);
+            lanes[i].increment.set(lane, Phase::fromCycles(increment.start * rateScale));
+            lanes[i].incrementStep.set(lane, Phase::stepFromCycles((increment.end - increment.start) * rateScale * stepScale));
+            
+            // radians to cycles, the kernel adds modulation straight onto the phase
+            auto modIndex = getModIndex(controls[i], expression);
+            lanes[i].modIndex.set(lane, modIndex.start * modIndexScale);
+            lanes[i].modIndexStep.set(lane, (modIndex.end - modIndex.start) * (float) stepScale * modIndexScale);
+        }
+    }
+    
+    // operators whose envelope stays at zero for the block renderControls was last called for
+    juce::uint32 getSilentOperators() const { return silentOperators; }
+    
+    template <int NumOperators, typename Vec>
+    void storeLane(const VoiceKernel::VoiceLanes<Vec, NumOperators>& lanes, size_t lane, float lastOutput)
+    {
+        for (int i = 0; i < NumOperators; i++)
+        {
+            op[i].setPhase(lanes[i].phase.get(lane));
+            operatorOutput[i] = lanes[i].output.get(lane);
+        }
+        outputSample = lastOutput;
     }
     
 private:
-    std::array<float, 4> toBinary4(int input)
-   {
-       std::array<float, 4> bits;
-       for (int i = 0; i < 4; ++i)
-           bits[i] = (input >> i) & 1;
-       return bits;
-   }
+    // the patch's modulation index with the note's pressure added and its slide applied
+    Ramp getModIndex(const OperatorControls& controls, const NoteExpression& expression) const
+    {
+        const auto v = (size_t) index;
+        return { (controls.modIndex.start + expression.modIndexStart[v]) * expression.brightnessStart[v],
+                 (controls.modIndex.end + expression.modIndexEnd[v]) * expression.brightnessEnd[v] };
+    }
+    
+    void reset()
+    {
+        envelope.reset();
+        pendingNoteOn = pendingNoteOff = false;
+        
+        operatorOutput.fill(0.0f);
+        outputSample = 0.0f;
+        isReleasing = false;
+        clearCurrentNote();
+    }
+    
+    static constexpr int maxOperators = Routing::maxOperators;
+    static constexpr float silenceThreshold = 1.0e-5f; // -100 dB
     
     double sampleRate;
-    float outputSample;
-
-    float op0 = 0.0f, op1 = 0.0f, op2 = 0.0f, op3 = 0.0f, feedback = 0.0f; // unit delays for algorithm
+    int index = 0;
+    float outputSample = 0.0f;
     
-    std::array<float, 4> op3Gain = { 0.0f, 0.0f, 0.0f, 0.0f };
-    std::array<float, 4> op2Gain = { 0.0f, 0.0f, 0.0f, 0.0f };
-    std::array<float, 4> op1Gain = { 0.0f, 0.0f, 0.0f, 0.0f };
-    std::array<float, 4> op0Gain = { 0.0f, 0.0f, 0.0f, 0.0f };
-    std::array<float, 4> outputGain = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const Tuning::Table* tuning = nullptr;
+    Glide glide;
+    float glideStart = -1.0f;
+    float noteFrequency = 440.0f; // Hz at the glide's current pitch
+    bool isReleasing = false;
+    bool pendingNoteOn = false, pendingNoteOff = false;
+    bool isMoving = false, moveRetriggers = false, moveSlides = false;
+    juce::uint32 silentOperators = 0;
+
+    std::array<float, maxOperators> operatorOutput {}; // unit delays for algorithm
+
+    std::array<FMOperator, maxOperators> op;
+    Envelope::Generator envelope;
+};
+
+
 
-    std::array<FMOperator, 4> op;
+// Up to one SIMD register's worth of voices rendered together, one voice per lane.
+class VoiceGroup
+{
+public:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int maxVoices = (int) Lanes::SIMDNumElements;
+    
+    void prepareToPlay(int samplesPerBlock);
+    
+    void start(int oversamplingStage) { stage = oversamplingStage; numVoices = 0; }
+    void add(SynthVoice& voice) { voices[numVoices++] = &voice; }
+    bool isFull() const { return numVoices == maxVoices; }
+    int getStage() const { return stage; }
+    
+    // renders the group's voices into its own output at 2^stage times the base rate.
+    // numSamples is at the base rate and must not exceed the prepared block size
+    void render(int numSamples, const RenderContext& context);
+    const float* getMix() const { return mix.data(); }
+    
+private:
+    template <typename SineType>
+    void renderSine(int numSamples, const RenderContext& context);
+    
+    template <typename SineType, int NumOperators>
+    void renderWith(int numSamples, const RenderContext& context);
+    
+    std::vector<float> mix;
+    std::array<SynthVoice*, maxVoices> voices {};
+    int numVoices = 0;
+    int stage = 0;
 };
 
+class FledgeSynthesiser : public juce::Synthesiser
+{
+public:
+    static constexpr int maxVoices = VoiceAllocator::maxVoices;
+    
+    enum class VoiceMode { poly, mono, legato };
+    static inline const juce::StringArray voiceModeNames { "Poly", "Mono", "Legato" };
+    
+    // envelopes and smoothing update this often whatever the sample rate and host block size
+    static constexpr double controlPeriod = 0.001;
+    
+    void prepareToPlay(double sampleRate, int samplesPerBlock);
+    
+    // only the first numVoices of the pool take new notes, voices above it are released
+    void setPolyphony(int numVoices);
+    void setStealPolicy(VoiceAllocator::StealPolicy policy);
+    void setVoiceMode(VoiceMode mode);
+    
+    void noteOn(int midiChannel, int midiNoteNumber, float velocity) override;
+    void noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override;
+    void handleSustainPedal(int midiChannel, bool isDown) override;
+    void handlePitchWheel(int midiChannel, int wheelValue) override;
+    void handleController(int midiChannel, int controllerNumber, int controllerValue) override;
+    void handleChannelPressure(int midiChannel, int channelPressureValue) override;
+    void handleAftertouch(int midiChannel, int midiNoteNumber, int aftertouchValue) override;
+    
+    // call between blocks from the audio thread, the patch stays fixed while voices render
+    void setPatch(const Patch& newPatch);
+    
+    // renders the voice groups on the shared worker pool, the output is the same either way
+    void setMultithreaded(bool shouldBeMultithreaded)
+    {
+        isMultithreaded = shouldBeMultithreaded;
+        if (isMultithreaded)
+            workerPool->requestWorkers();
+    }
+    
+protected:
+    void renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+    void renderVoices(juce::AudioBuffer<double>& outputAudio, int startSample, int numSamples) override;
+    
+private:
+    struct HeldNote { int midiChannel, midiNoteNumber; };
+    
+    Envelope::Shape makeEnvelopeShape() const;
+    void setAllocatorLimit(int numVoices);
+    void releaseVoice(int index, float velocity, bool allowTailOff);
+    void monoNoteOn(juce::SynthesiserSound* sound, int midiChannel, int midiNoteNumber, float velocity);
+    void monoNoteOff(int midiNoteNumber, float velocity, bool allowTailOff);
+    void removeHeldNote(int midiNoteNumber);
+    void moveMonoVoice(juce::SynthesiserSound* sound, const HeldNote& note, float velocity, bool retrigger, bool shouldSlide);
+    float getGlideStart(bool isOverlapping) const;
+    bool isAnyKeyDown() const;
+    static void renderGroup(void* synth, int group, int thread);
+    void renderSharedOscillators(int numSamples, juce::uint32 stages);
+    
+    template <typename SineType>
+    void renderSharedOscillatorsWith(int numSamples, juce::uint32 stages);
+    
+    template <typename SampleType>
+    void renderVoicesInto(juce::AudioBuffer<SampleType>& outputAudio, int startSample, int numSamples);
+    
+    // every full group plus one partly filled group per rate
+    static constexpr int maxGroups = maxVoices / VoiceGroup::maxVoices + Oversampler::maxStages + 1;
+    std::array<VoiceGroup, maxGroups> groups;
+    int numGroups = 0;
+    int renderSamples = 0;
+    
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+    WorkerPool::Batch batch;
+    bool isMultithreaded = false;
+    
+    // one buffer per operator and rate, the phases run free rather than restarting with notes
+    std::array<std::array<std::vector<float>, Oversampler::maxStages + 1>, Routing::maxOperators> sharedOscillators;
+    std::array<juce::uint32, Routing::maxOperators> sharedPhases {};
+    
+    Oversampler oversampler;
+    int maxBlockSamples = 0;
+    int controlInterval = 1;      // samples per control period
+    int samplesUntilControl = 0;  // carries over between host blocks
+    
+    Patch patch;
+    PatchSmoother smoother;
+    NoteExpression expression;
+    RenderContext context;
+    
+    VoiceAllocator allocator;
+    VoiceMode voiceMode = VoiceMode::poly;
+    int polyphony = maxVoices;
+    std::array<HeldNote, 128> heldNotes; // mono note stack, last is sounding
+    int numHeldNotes = 0;
+    float lastPitch = -1.0f; // of the last note played, where the next one may glide from
+    static constexpr int modWheelController = 1;
+    static constexpr int slideController = 74; // MPE timbre
+};
@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    WorkerPool.cpp
+    Created: 18 Oct 2026 9:32:44pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // eases the core while spinning, and lets a hyperthreaded sibling run
+    inline void pause()
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (defined (__GNUC__) || defined (__clang__))
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    cancelPendingUpdate();
+    const int count = numWorkers.load();
+
+    for (int i = 0; i < count; i++)
+        workers[(size_t) i]->signalThreadShouldExit();
+
+    for (int i = 0; i < count; i++)
+    {
+        workers[(size_t) i]->wake();
+        workers[(size_t) i]->stopThread(1000);
+    }
+}
+
+void WorkerPool::requestWorkers()
+{
+    if (! isRequested.exchange(true))
+        triggerAsyncUpdate();
+}
+
+void WorkerPool::handleAsyncUpdate()
+{
+    // leave one core for the audio thread, affinity masks only reach 32 cores
+    int count = juce::jlimit(0, maxWorkers, juce::SystemStats::getNumPhysicalCpus() - 1);
+    int numCores = juce::jmin(32, juce::SystemStats::getNumCpus());
+
+    for (int i = 0; i < count; i++)
+    {
+        workers[(size_t) i] = std::make_unique<Worker>(*this, i + 1);
+        workers[(size_t) i]->setAffinityMask(juce::uint32(1) << ((i + 1) % numCores));
+        workers[(size_t) i]->startThread(juce::Thread::Priority::highest);
+    }
+
+    // only now can run see them
+    numWorkers.store(count);
+}
+
+void WorkerPool::run(Batch& batch, Job job, void* context, int numJobs)
+{
+    batch.job = job;
+    batch.context = context;
+    batch.numJobs = numJobs;
+    batch.numDone.store(0);
+    batch.next.store(0);
+
+    Slot* slot = nullptr;
+    if (numJobs > 1)
+    {
+        for (auto& s : slots)
+        {
+            Batch* empty = nullptr;
+            if (s.batch.compare_exchange_strong(empty, &batch))
+            {
+                slot = &s;
+                break;
+            }
+        }
+    }
+
+    // only sleeping workers need the event, signalling it is the one call here that may enter the kernel
+    if (slot != nullptr)
+        for (int i = 0; i < numWorkers.load(); i++)
+            workers[(size_t) i]->wake();
+
+    // with no free slot the caller simply does everything itself
+    runJobs(batch, 0);
+
+    while (batch.numDone.load() < numJobs)
+        pause();
+
+    if (slot != nullptr)
+    {
+        slot->batch.store(nullptr);
+        while (slot->numUsers.load() > 0)
+            pause();
+    }
+}
+
+void WorkerPool::runJobs(Batch& batch, int thread)
+{
+    for (;;)
+    {
+        int index = batch.next.fetch_add(1);
+        if (index >= batch.numJobs)
+            return;
+
+        batch.job(batch.context, index, thread);
+        batch.numDone.fetch_add(1);
+    }
+}
+
+bool WorkerPool::helpAnyBatch(int thread)
+{
+    bool didHelp = false;
+    for (auto& slot : slots)
+    {
+        // announce the use before reading the pointer, the owner waits for it to drop
+        slot.numUsers.fetch_add(1);
+        if (auto* batch = slot.batch.load())
+        {
+            if (batch->next.load() < batch->numJobs)
+            {
+                runJobs(*batch, thread);
+                didHelp = true;
+            }
+        }
+        slot.numUsers.fetch_sub(1);
+    }
+    return didHelp;
+}
+
+bool WorkerPool::hasWork() const
+{
+    for (auto& slot : slots)
+        if (slot.batch.load() != nullptr)
+            return true;
+    return false;
+}
+
+WorkerPool::Worker::Worker(WorkerPool& p, int t)
+    : juce::Thread("Fledge Worker " + juce::String(t)), pool(p), thread(t)
+{
+}
+
+void WorkerPool::Worker::run()
+{
+    // the voices rendered here decay into denormals just as they do on the audio thread
+    juce::ScopedNoDenormals noDenormals;
+
+    int spins = 0;
+    while (! threadShouldExit())
+    {
+        if (pool.helpAnyBatch(thread))
+        {
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < spinsBeforeSleeping)
+        {
+            pause();
+            continue;
+        }
+
+        // check again after saying so, a batch posted in between either is seen here or wakes us
+        isSleeping.store(true);
+        if (! pool.hasWork() && ! threadShouldExit())
+            wakeUp.wait();
+        isSleeping.store(false);
+        spins = 0;
+    }
+}
+
+void WorkerPool::Worker::wake()
+{
+    if (isSleeping.load())
+        wakeUp.signal();
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    WorkerPool.h
+    Created: 18 Oct 2026 9:32:44pm
+    Author:  Takuma Matsui
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Worker threads that help the audio thread through a batch of independent jobs.
+// One pool is shared by every instance in the process through a
+// SharedResourcePointer, so a session full of Fledges never runs more render
+// threads than there are cores. Jobs are claimed with an atomic counter, workers
+// spin for a while after running out of work and only then sleep.
+//
+// The workers only start once an instance asks for them, a session that never turns
+// multithreading on never runs them.
+class WorkerPool : private juce::AsyncUpdater
+{
+public:
+    static constexpr int maxWorkers = 15;
+
+    using Job = void (*)(void* context, int job, int thread);
+
+    // owned by the caller and reused for every run, it must outlive the pool's use of it
+    struct Batch
+    {
+        Job job = nullptr;
+        void* context = nullptr;
+        int numJobs = 0;
+        std::atomic<int> next { 0 };
+        std::atomic<int> numDone { 0 };
+    };
+
+    WorkerPool() = default;
+    ~WorkerPool() override;
+
+    // any thread, the workers are started on the message thread. Until then
+    // getNumThreads is 1 and run does every job on the caller
+    void requestWorkers();
+
+    // thread 0 is the caller, workers are 1 to getNumThreads() - 1
+    int getNumThreads() const { return numWorkers.load() + 1; }
+
+    // calls job(context, index, thread) once for every index below numJobs and returns
+    // when all of them are done. The caller works on the batch too, so it completes
+    // even when every worker is busy with other instances
+    void run(Batch& batch, Job job, void* context, int numJobs);
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(WorkerPool& pool, int thread);
+        void run() override;
+        void wake();
+
+    private:
+        WorkerPool& pool;
+        const int thread;
+        juce::WaitableEvent wakeUp;
+        std::atomic<bool> isSleeping { false };
+    };
+
+    // one running batch, numUsers counts the workers that may hold its pointer
+    struct Slot
+    {
+        std::atomic<Batch*> batch { nullptr };
+        std::atomic<int> numUsers { 0 };
+    };
+
+    void handleAsyncUpdate() override;
+    static void runJobs(Batch& batch, int thread);
+    bool helpAnyBatch(int thread);
+    bool hasWork() const;
+
+    static constexpr int maxBatches = 16;
+    static constexpr int spinsBeforeSleeping = 20000;
+
+    std::array<Slot, maxBatches> slots;
+    std::array<std::unique_ptr<Worker>, maxWorkers> workers;
+    std::atomic<int> numWorkers { 0 }; // set once they have all started
+    std::atomic<bool> isRequested { false };
+};